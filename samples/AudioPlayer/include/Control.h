@@ -3,19 +3,53 @@
 #include "NodeId.h"
 #include "UiTree.h"
 
-// Short hand for a UI tree which stores its color.
-typedef UiTreeT<ci::ColorAf> UiTree;
+class Control;
+class ControlPolicy;
+
+// Short hand for a UI tree which stores its color and sends pointer events to controls.
+typedef UiTreeT<ci::ColorAf, ControlPolicy> UiTree;
+
+/*
+ * The UI tree's event policy. Nodes call its methods directly, 
+ * and only for the mouse and touch events declared here. Each 
+ * one passes the event on to the control that owns the policy.
+ */
+class ControlPolicy : public UiTree::EventPolicy
+{
+public:
+	ControlPolicy( Control* control );
+
+	void	mouseDown( UiTree* node, ci::app::MouseEvent& event );
+	void	mouseDrag( UiTree* node, ci::app::MouseEvent& event );
+	void	mouseUp( UiTree* node, ci::app::MouseEvent& event );
+	void	touchesBegan( UiTree* node, ci::app::TouchEvent& event );
+	void	touchesEnded( UiTree* node, ci::app::TouchEvent& event );
+	void	touchesMoved( UiTree* node, ci::app::TouchEvent& event );
+private:
+	Control*	mControl;
+};
 
 // Extend the event handler into a UI control.
 class Control : public UiTree::EventHandlerInterface
 {
 public:
+	Control();
+	Control( const Control& rhs );
+
+	Control&	operator=( const Control& rhs );
+
 	virtual void connect( UiTree& node ) override;
+
+	// Returns the node this control was last connected to.
+	UiTree* getNode() const;
+
 	virtual void mouseDown( UiTree* node, ci::app::MouseEvent& event ) = 0;
 	virtual void mouseDrag( UiTree* node, ci::app::MouseEvent& event ) = 0;
 	virtual void mouseUp( UiTree* node, ci::app::MouseEvent& event ) = 0;
 	virtual void touchesBegan( UiTree* node, ci::app::TouchEvent& event ) = 0;
 	virtual void touchesEnded( UiTree* node, ci::app::TouchEvent& event ) = 0;
 	virtual void touchesMoved( UiTree* node, ci::app::TouchEvent& event ) = 0;
+private:
+	UiTree*			mNode = nullptr;
+	ControlPolicy	mPolicy;
 };
- 
\ No newline at end of file
@@ -15,7 +15,7 @@ public:
 	
 	// Returns the normalized slider position.
 	float	getPosition() const;
-	// Returns true if user is dragging slider.
+	// Returns true if the slider's node holds the pointer or a touch.
 	bool	isDragging() const;
 
 	// Sets the normalized slider position [ 0.0 - 1.0 ].
@@ -29,7 +29,6 @@ public:
 	void	touchesMoved( UiTree* node, ci::app::TouchEvent& event ) override;
 private:
 	void	calcPosition( const ci::ivec2& v );
-	bool	mDragging = false;
 	float	mPosition = 0.0f;
 };
  
\ No newline at end of file
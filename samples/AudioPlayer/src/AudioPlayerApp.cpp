@@ -27,7 +27,7 @@ private:
 	void							drawTree( const UiTree& node );
 	void							showTree( UiTree& node );
 
-	// These controls are UiTree::EventHandler implementations.
+	// Each control hands its node a ControlPolicy, which calls back into the control.
 	Button							mButtonForward;
 	Button							mButtonPlay;
 	Button							mButtonRewind;
@@ -1,16 +1,73 @@
 #include "Control.h"
 
+using namespace ci;
+using namespace ci::app;
+using namespace std;
+
+ControlPolicy::ControlPolicy( Control* control )
+	: mControl( control )
+{
+}
+
+void ControlPolicy::mouseDown( UiTree* node, MouseEvent& event )
+{
+	mControl->mouseDown( node, event );
+}
+
+void ControlPolicy::mouseDrag( UiTree* node, MouseEvent& event )
+{
+	mControl->mouseDrag( node, event );
+}
+
+void ControlPolicy::mouseUp( UiTree* node, MouseEvent& event )
+{
+	mControl->mouseUp( node, event );
+}
+
+void ControlPolicy::touchesBegan( UiTree* node, TouchEvent& event )
+{
+	mControl->touchesBegan( node, event );
+}
+
+void ControlPolicy::touchesEnded( UiTree* node, TouchEvent& event )
+{
+	mControl->touchesEnded( node, event );
+}
+
+void ControlPolicy::touchesMoved( UiTree* node, TouchEvent& event )
+{
+	mControl->touchesMoved( node, event );
+}
+
+Control::Control()
+	: mPolicy( this )
+{
+}
+
+// A copy gets its own policy, which points back at the copy.
+Control::Control( const Control& rhs )
+	: mPolicy( this )
+{
+}
+
+Control& Control::operator=( const Control& rhs )
+{
+	return *this;
+}
+
 /*
  * By overriding the connect method, we can 
- * hook up fewer events to make the handler
- * a little more lightweight.
+ * hand the node a policy instead of six 
+ * handlers. The node calls it directly, 
+ * and routes it no other events.
  */
 void Control::connect( UiTree& node )
 {
-	node.connectMouseDownEventHandler(		&Control::mouseDown,	this );
-	node.connectMouseDragEventHandler(		&Control::mouseDrag,	this );
-	node.connectMouseUpEventHandler(		&Control::mouseUp,		this );
-	node.connectTouchesBeganEventHandler(	&Control::touchesBegan, this );
-	node.connectTouchesEndedEventHandler(	&Control::touchesEnded,	this );
-	node.connectTouchesMovedEventHandler(	&Control::touchesMoved,	this );
+	mNode = &node;
+	node.connectEventPolicy( &mPolicy );
+}
+
+UiTree* Control::getNode() const
+{
+	return mNode;
 }
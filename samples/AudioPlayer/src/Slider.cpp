@@ -15,7 +15,6 @@ Slider::Slider( const Slider& rhs )
 
 Slider& Slider::operator=( const Slider& rhs )
 {
-	mDragging = rhs.mDragging;
 	mPosition = rhs.mPosition;
 	return *this;
 }
@@ -33,7 +32,8 @@ float Slider::getPosition() const
 
 bool Slider::isDragging() const
 {
-	return mDragging;
+	const UiTree* node = getNode();
+	return node != nullptr && ( node->hasPointerCapture() || node->hasTouchCapture() );
 }
 
 void Slider::setPosition( float v )
@@ -45,39 +45,41 @@ void Slider::mouseDown( UiTree* node, MouseEvent& event )
 {
 	if ( node->isMouseOver() ) {
 		calcPosition( event.getPos() );
-		mDragging = true;
+
+		// Drags go straight to this node until the button is released.
+		node->capturePointer();
 	}
 }
 
 void Slider::mouseDrag( UiTree* node, MouseEvent& event ) 
 {
-	if ( mDragging ) {
+	if ( node->hasPointerCapture() ) {
 		calcPosition( event.getPos() );
 	}
 }
 
 void Slider::mouseUp( UiTree* node, MouseEvent& event ) 
 {
-	mDragging = false;
 }
 
 void Slider::touchesBegan( UiTree* node, TouchEvent& event ) 
 {
 	if ( node->hasTouches() ) {
 		calcPosition( event.getTouches().begin()->getPos() );
-		mDragging = true;
+		node->capturePointer( event.getTouches().begin()->getId() );
 	}
 }
 
 void Slider::touchesEnded( UiTree* node, TouchEvent& event ) 
 {
-	mDragging = false;
 }
 
 void Slider::touchesMoved( UiTree* node, TouchEvent& event ) 
 {
-	if ( mDragging ) {
-		calcPosition( event.getTouches().begin()->getPos() );
+	for ( const TouchEvent::Touch& touch : event.getTouches() ) {
+		if ( node->hasPointerCapture( touch.getId() ) ) {
+			calcPosition( touch.getPos() );
+		}
 	}
 }
 
@@ -2,67 +2,157 @@
 
 #include "cinder/app/App.h"
 #include "cinder/AxisAlignedBox.h"
+#include "cinder/Matrix.h"
 #include "cinder/Quaternion.h"
 #include "cinder/Vector.h"
 
 #include "cinder/Log.h"
 #include "cinder/Timer.h"
 
+#include <algorithm>
+#include <functional>
+#include <limits>
+#include <list>
+#include <memory>
+#include <type_traits>
+#include <unordered_map>
+
+#if defined( __SSE2__ ) || defined( _M_X64 ) || ( defined( _M_IX86_FP ) && _M_IX86_FP >= 2 )
+#define UI_TREE_SSE2
+#include <emmintrin.h>
+#endif
+
+/////////////////////////////////////////////////////////////////////////////////
+
+/*
+ * Optional subsystems of a UiTreeT, combined into its "F" 
+ * parameter. The per-node state and code paths of a feature 
+ * left out are compiled away. Transforms, hierarchy, data and 
+ * hit testing are always available, as are handlers for
+ * lifecycle events. Connecting a handler for an input event
+ * left out, or setting a velocity without animation, fails
+ * to compile instead of being ignored. UiTreeFeature_Input
+ * combines the three input features. UiTreeFeature_SpatialIndex 
+ * keeps world bounds, grid cells and an inverse frame matrix 
+ * in each node for the spatial indexes, query() by rectangle 
+ * and getWorldBounds(). Without it, hit tests visit every 
+ * node and invert frames as they go. UiTreeFeature_Transform2D 
+ * is a mode rather than a subsystem, so it is not part of 
+ * UiTreeFeature_All. It stores transforms as vec2s, a scalar 
+ * angle about z and 3x2 affine matrices.
+ */
+enum : uint32_t
+{
+	UiTreeFeature_None			= 0, 
+	UiTreeFeature_Animation		= 1 << 0, 
+	UiTreeFeature_Keyboard		= 1 << 1, 
+	UiTreeFeature_Mouse			= 1 << 2, 
+	UiTreeFeature_Touch			= 1 << 3, 
+	UiTreeFeature_Transform2D	= 1 << 4, 
+	UiTreeFeature_SpatialIndex	= 1 << 5, 
+	UiTreeFeature_Input			= UiTreeFeature_Keyboard | UiTreeFeature_Mouse | UiTreeFeature_Touch, 
+	UiTreeFeature_All			= UiTreeFeature_Animation | UiTreeFeature_Input | UiTreeFeature_SpatialIndex
+} typedef UiTreeFeature;
+
 /////////////////////////////////////////////////////////////////////////////////
 
-template<typename T>
+template<typename T, typename P = void, uint32_t F = UiTreeFeature_All>
 class UiTreeT
 {
 public:
 	class EventHandlerInterface
 	{
 	public:
-		inline virtual void disable( UiTreeT<T>* ) {}
-		inline virtual void enable( UiTreeT<T>* ) {}
-		inline virtual void hide( UiTreeT<T>* ) {}
-		inline virtual void keyDown( UiTreeT<T>*, ci::app::KeyEvent& event ) {}
-		inline virtual void keyUp( UiTreeT<T>*, ci::app::KeyEvent& event ) {}
-		inline virtual void mouseDown( UiTreeT<T>*, ci::app::MouseEvent& event ) {}
-		inline virtual void mouseDrag( UiTreeT<T>*, ci::app::MouseEvent& event ) {}
-		inline virtual void mouseMove( UiTreeT<T>*, ci::app::MouseEvent& event ) {}
-		inline virtual void mouseOut( UiTreeT<T>* ) {}
-		inline virtual void mouseOver( UiTreeT<T>* ) {}
-		inline virtual void mouseUp( UiTreeT<T>*, ci::app::MouseEvent& event ) {}
-		inline virtual void mouseWheel( UiTreeT<T>*, ci::app::MouseEvent& event ) {}
-		inline virtual void resize( UiTreeT<T>* ) {}
-		inline virtual void show( UiTreeT<T>* ) {}
-		inline virtual void touchesBegan( UiTreeT<T>*, ci::app::TouchEvent& event ) {}
-		inline virtual void touchesEnded( UiTreeT<T>*, ci::app::TouchEvent& event ) {}
-		inline virtual void touchesMoved( UiTreeT<T>*, ci::app::TouchEvent& event ) {}
-		inline virtual void touchOut( UiTreeT<T>*, uint32_t ) {}
-		inline virtual void touchOver( UiTreeT<T>*, uint32_t ) {}
-		inline virtual void update( UiTreeT<T>* ) {}
-
-		inline virtual void	connect( UiTreeT<T>& node )
-		{
-			node.connectDisableEventHandler(		&EventHandlerInterface::disable,		this );
-			node.connectEnableEventHandler(			&EventHandlerInterface::enable,			this );
-			node.connectHideEventHandler(			&EventHandlerInterface::hide,			this );
-			node.connectKeyDownEventHandler(		&EventHandlerInterface::keyDown,		this );
-			node.connectKeyUpEventHandler(			&EventHandlerInterface::keyUp,			this );
-			node.connectMouseDownEventHandler(		&EventHandlerInterface::mouseDown,		this );
-			node.connectMouseDragEventHandler(		&EventHandlerInterface::mouseDrag,		this );
-			node.connectMouseMoveEventHandler(		&EventHandlerInterface::mouseMove,		this );
-			node.connectMouseOutEventHandler(		&EventHandlerInterface::mouseOut,		this );
-			node.connectMouseOverEventHandler(		&EventHandlerInterface::mouseOver,		this );
-			node.connectMouseUpEventHandler(		&EventHandlerInterface::mouseUp,		this );
-			node.connectMouseWheelEventHandler(		&EventHandlerInterface::mouseWheel,		this );
-			node.connectResizeEventHandler(			&EventHandlerInterface::resize,			this );
-			node.connectShowEventHandler(			&EventHandlerInterface::show,			this );
-			node.connectTouchesBeganEventHandler(	&EventHandlerInterface::touchesBegan, 	this );
-			node.connectTouchesEndedEventHandler(	&EventHandlerInterface::touchesEnded,	this );
-			node.connectTouchesMovedEventHandler(	&EventHandlerInterface::touchesMoved,	this );
-			node.connectTouchOutEventHandler(		&EventHandlerInterface::touchOut,		this );
-			node.connectTouchOverEventHandler(		&EventHandlerInterface::touchOver,		this );
-			node.connectUpdateEventHandler(			&EventHandlerInterface::update,			this );
+		inline virtual void blur( UiTreeT<T, P, F>* ) {}
+		inline virtual void disable( UiTreeT<T, P, F>* ) {}
+		inline virtual void enable( UiTreeT<T, P, F>* ) {}
+		inline virtual void focus( UiTreeT<T, P, F>* ) {}
+		inline virtual void hide( UiTreeT<T, P, F>* ) {}
+		inline virtual void keyDown( UiTreeT<T, P, F>*, ci::app::KeyEvent& event ) {}
+		inline virtual void keyUp( UiTreeT<T, P, F>*, ci::app::KeyEvent& event ) {}
+		inline virtual void mouseDown( UiTreeT<T, P, F>*, ci::app::MouseEvent& event ) {}
+		inline virtual void mouseDrag( UiTreeT<T, P, F>*, ci::app::MouseEvent& event ) {}
+		inline virtual void mouseMove( UiTreeT<T, P, F>*, ci::app::MouseEvent& event ) {}
+		inline virtual void mouseOut( UiTreeT<T, P, F>* ) {}
+		inline virtual void mouseOver( UiTreeT<T, P, F>* ) {}
+		inline virtual void mouseUp( UiTreeT<T, P, F>*, ci::app::MouseEvent& event ) {}
+		inline virtual void mouseWheel( UiTreeT<T, P, F>*, ci::app::MouseEvent& event ) {}
+		inline virtual void resize( UiTreeT<T, P, F>* ) {}
+		inline virtual void show( UiTreeT<T, P, F>* ) {}
+		inline virtual void touchesBegan( UiTreeT<T, P, F>*, ci::app::TouchEvent& event ) {}
+		inline virtual void touchesEnded( UiTreeT<T, P, F>*, ci::app::TouchEvent& event ) {}
+		inline virtual void touchesMoved( UiTreeT<T, P, F>*, ci::app::TouchEvent& event ) {}
+		inline virtual void touchOut( UiTreeT<T, P, F>*, uint32_t ) {}
+		inline virtual void touchOver( UiTreeT<T, P, F>*, uint32_t ) {}
+		inline virtual void update( UiTreeT<T, P, F>* ) {}
+
+		/*
+		 * Connects each method to "node", leaving out the events a 
+		 * tree type built without their input feature never sends.
+		 */
+		inline virtual void	connect( UiTreeT<T, P, F>& node )
+		{
+			using namespace std::placeholders;
+			node.connectSentEventHandler<EventType_Blur>( std::bind( &EventHandlerInterface::blur, this, _1 ) );
+			node.connectSentEventHandler<EventType_Disable>( std::bind( &EventHandlerInterface::disable, this, _1 ) );
+			node.connectSentEventHandler<EventType_Enable>( std::bind( &EventHandlerInterface::enable, this, _1 ) );
+			node.connectSentEventHandler<EventType_Focus>( std::bind( &EventHandlerInterface::focus, this, _1 ) );
+			node.connectSentEventHandler<EventType_Hide>( std::bind( &EventHandlerInterface::hide, this, _1 ) );
+			node.connectSentEventHandler<EventType_KeyDown>( std::bind( &EventHandlerInterface::keyDown, this, _1, _2 ) );
+			node.connectSentEventHandler<EventType_KeyUp>( std::bind( &EventHandlerInterface::keyUp, this, _1, _2 ) );
+			node.connectSentEventHandler<EventType_MouseDown>( std::bind( &EventHandlerInterface::mouseDown, this, _1, _2 ) );
+			node.connectSentEventHandler<EventType_MouseDrag>( std::bind( &EventHandlerInterface::mouseDrag, this, _1, _2 ) );
+			node.connectSentEventHandler<EventType_MouseMove>( std::bind( &EventHandlerInterface::mouseMove, this, _1, _2 ) );
+			node.connectSentEventHandler<EventType_MouseOut>( std::bind( &EventHandlerInterface::mouseOut, this, _1 ) );
+			node.connectSentEventHandler<EventType_MouseOver>( std::bind( &EventHandlerInterface::mouseOver, this, _1 ) );
+			node.connectSentEventHandler<EventType_MouseUp>( std::bind( &EventHandlerInterface::mouseUp, this, _1, _2 ) );
+			node.connectSentEventHandler<EventType_MouseWheel>( std::bind( &EventHandlerInterface::mouseWheel, this, _1, _2 ) );
+			node.connectSentEventHandler<EventType_Resize>( std::bind( &EventHandlerInterface::resize, this, _1 ) );
+			node.connectSentEventHandler<EventType_Show>( std::bind( &EventHandlerInterface::show, this, _1 ) );
+			node.connectSentEventHandler<EventType_TouchesBegan>( std::bind( &EventHandlerInterface::touchesBegan, this, _1, _2 ) );
+			node.connectSentEventHandler<EventType_TouchesEnded>( std::bind( &EventHandlerInterface::touchesEnded, this, _1, _2 ) );
+			node.connectSentEventHandler<EventType_TouchesMoved>( std::bind( &EventHandlerInterface::touchesMoved, this, _1, _2 ) );
+			node.connectSentEventHandler<EventType_TouchOut>( std::bind( &EventHandlerInterface::touchOut, this, _1, _2 ) );
+			node.connectSentEventHandler<EventType_TouchOver>( std::bind( &EventHandlerInterface::touchOver, this, _1, _2 ) );
+			node.connectSentEventHandler<EventType_Update>( std::bind( &EventHandlerInterface::update, this, _1 ) );
 		} 
 	};
 
+	/*
+	 * Base for the event policy "P". Nothing here is virtual. A 
+	 * node calls its policy's methods directly, and only for the 
+	 * events "P" redeclares.
+	 */
+	class EventPolicy
+	{
+	public:
+		inline void blur( UiTreeT<T, P, F>* ) {}
+		inline void disable( UiTreeT<T, P, F>* ) {}
+		inline void enable( UiTreeT<T, P, F>* ) {}
+		inline void focus( UiTreeT<T, P, F>* ) {}
+		inline void hide( UiTreeT<T, P, F>* ) {}
+		inline void keyDown( UiTreeT<T, P, F>*, ci::app::KeyEvent& ) {}
+		inline void keyUp( UiTreeT<T, P, F>*, ci::app::KeyEvent& ) {}
+		inline void mouseDown( UiTreeT<T, P, F>*, ci::app::MouseEvent& ) {}
+		inline void mouseDrag( UiTreeT<T, P, F>*, ci::app::MouseEvent& ) {}
+		inline void mouseMove( UiTreeT<T, P, F>*, ci::app::MouseEvent& ) {}
+		inline void mouseOut( UiTreeT<T, P, F>* ) {}
+		inline void mouseOver( UiTreeT<T, P, F>* ) {}
+		inline void mouseUp( UiTreeT<T, P, F>*, ci::app::MouseEvent& ) {}
+		inline void mouseWheel( UiTreeT<T, P, F>*, ci::app::MouseEvent& ) {}
+		inline void resize( UiTreeT<T, P, F>* ) {}
+		inline void show( UiTreeT<T, P, F>* ) {}
+		inline void touchesBegan( UiTreeT<T, P, F>*, ci::app::TouchEvent& ) {}
+		inline void touchesEnded( UiTreeT<T, P, F>*, ci::app::TouchEvent& ) {}
+		inline void touchesMoved( UiTreeT<T, P, F>*, ci::app::TouchEvent& ) {}
+		inline void touchOut( UiTreeT<T, P, F>*, uint32_t ) {}
+		inline void touchOver( UiTreeT<T, P, F>*, uint32_t ) {}
+		inline void update( UiTreeT<T, P, F>* ) {}
+	};
+
+	// The type nodes dispatch policy calls to. EventPolicy when "P" is void.
+	typedef typename std::conditional<std::is_void<P>::value, EventPolicy, P>::type EventPolicyType;
+
 	enum : uint8_t
 	{
 		CollisionType_Circle, 
@@ -71,220 +161,740 @@ public:
 		CollisionType_Sphere
 	} typedef CollisionType;
 
+	/*
+	 * Events a node can handle. A node's handlers are kept in a 
+	 * table allocated when the first one is connected, so a node 
+	 * without handlers only pays for a pointer.
+	 */
+	enum : uint8_t
+	{
+		EventType_Blur, 
+		EventType_Disable, 
+		EventType_Enable, 
+		EventType_Focus, 
+		EventType_Hide, 
+		EventType_KeyDown, 
+		EventType_KeyUp, 
+		EventType_MouseDown, 
+		EventType_MouseDrag, 
+		EventType_MouseMove, 
+		EventType_MouseOut, 
+		EventType_MouseOver, 
+		EventType_MouseUp, 
+		EventType_MouseWheel, 
+		EventType_Resize, 
+		EventType_Show, 
+		EventType_TouchesBegan, 
+		EventType_TouchesEnded, 
+		EventType_TouchesMoved, 
+		EventType_TouchOut, 
+		EventType_TouchOver, 
+		EventType_Update
+	} typedef EventType;
+
+	// The handler signature for events of type "E".
+	template<EventType E>
+	using EventHandler = typename std::conditional<E == EventType_KeyDown || E == EventType_KeyUp, 
+		std::function<void( UiTreeT<T, P, F>*, ci::app::KeyEvent& )>, 
+		typename std::conditional<E == EventType_MouseDown || E == EventType_MouseDrag || E == EventType_MouseMove || 
+			E == EventType_MouseUp || E == EventType_MouseWheel, 
+		std::function<void( UiTreeT<T, P, F>*, ci::app::MouseEvent& )>, 
+		typename std::conditional<E == EventType_TouchesBegan || E == EventType_TouchesEnded || E == EventType_TouchesMoved, 
+		std::function<void( UiTreeT<T, P, F>*, ci::app::TouchEvent& )>, 
+		typename std::conditional<E == EventType_TouchOut || E == EventType_TouchOver, 
+		std::function<void( UiTreeT<T, P, F>*, uint32_t )>, 
+		std::function<void( UiTreeT<T, P, F>* )>>::type>::type>::type>::type;
+
+	/*
+	 * Selects when mouse and touch moves reach the tree. With 
+	 * InputMode_Coalesce, the root queues mouse moves, drags 
+	 * and touch moves as they arrive and dispatches the latest 
+	 * of each, per pointer, once per update() or flushInput(). 
+	 * InputMode_Samples also keeps the positions merged into 
+	 * each queued event for getMouseSamples() and 
+	 * getTouchSamples(). Queued events are flushed before any 
+	 * other mouse or touch event, so ordering is kept.
+	 */
+	enum : uint8_t
+	{
+		InputMode_Immediate, 
+		InputMode_Coalesce, 
+		InputMode_Samples
+	} typedef InputMode;
+
+	/*
+	 * Stable reference to a node, valid until the node leaves its 
+	 * tree or is assigned over. The low 32 bits index the root's 
+	 * handle table and the high 32 bits hold that entry's 
+	 * generation, which advances when the node is removed. A 
+	 * stale handle is rejected rather than resolving to whichever 
+	 * node reuses the entry.
+	 */
+	typedef uint64_t Handle;
+
+	enum : uint32_t
+	{
+		Handle_None = 0xffffffff
+	};
+
+	// Written by hitTest() for points that miss every node.
+	enum : uint64_t
+	{
+		Id_None = 0xffffffffffffffffull
+	};
+
+	/*
+	 * Selects the kernel update() uses to integrate animation. 
+	 * UpdateMode_Scalar is the default. UpdateMode_Simd processes 
+	 * four nodes at a time with SSE2 and falls back to scalar 
+	 * code where SSE2 is unavailable. Rotations are vectorized 
+	 * only for groups of four that are all nearly at their 
+	 * targets, where slerp reduces to a lerp. Other groups run 
+	 * glm::slerp per lane, so SIMD mode pays off for translation, 
+	 * scale and registration more than rotation. Both modes agree 
+	 * to within float rounding.
+	 */
+	enum : uint8_t
+	{
+		UpdateMode_Scalar, 
+		UpdateMode_Simd
+	} typedef UpdateMode;
+
+	/*
+	 * Selects how contains() and hover tests find the nodes 
+	 * under a point. SpatialIndex_Bvh skips subtrees whose 
+	 * world space bounds miss the point. Bounds are 2D, in 
+	 * the window's x/y plane, and are refit lazily for the 
+	 * nodes whose transforms changed. SpatialIndex_Grid hashes 
+	 * each node's bounds into a uniform grid, which suits wide, 
+	 * shallow trees where sibling bounds overlap.
+	 */
+	enum : uint8_t
+	{
+		SpatialIndex_None, 
+		SpatialIndex_Bvh, 
+		SpatialIndex_Grid
+	} typedef SpatialIndex;
+
+	// Transform math for 3D nodes: vec3 channels, a quaternion and 4x4 matrices.
+	class Transform3D
+	{
+	public:
+		typedef ci::mat4 Matrix;
+		typedef ci::quat Rotation;
+		typedef ci::vec3 Vec;
+
+		// Returns "parent" followed by a translation, a rotation and a scale.
+		static inline Matrix calcFrame( const Matrix& parent, const Vec& translate, const Rotation& rotation, const Vec& scale )
+		{
+			return glm::scale( glm::translate( parent, translate ) * glm::toMat4( rotation ), scale );
+		}
+
+		static inline Matrix calcInverse( const Matrix& m )
+		{
+			return glm::inverse( m );
+		}
+
+		static inline Matrix calcScaled( const Matrix& m, const Vec& scale )
+		{
+			return glm::scale( m, scale );
+		}
+
+		static inline Rotation getRotation( float z )
+		{
+			return glm::angleAxis( z, ci::vec3( 0.0f, 0.0f, 1.0f ) );
+		}
+
+		static inline Rotation getRotation( const ci::quat& q )
+		{
+			return q;
+		}
+
+		static inline Rotation getRotationZero()
+		{
+			return ci::quat( 0.0f, 0.0f, 0.0f, 0.0f );
+		}
+
+		static inline Vec getVec( const ci::vec2& v )
+		{
+			return ci::vec3( v, 0.0f );
+		}
+
+		static inline Vec getVec( const ci::vec3& v )
+		{
+			return v;
+		}
+
+		// Returns true if "m" keeps the x/y plane facing the viewer.
+		static inline bool isFlat( const Matrix& m )
+		{
+			return m[ 2 ][ 0 ] == 0.0f && m[ 2 ][ 1 ] == 0.0f;
+		}
+
+		static inline ci::vec3 toVec3( const Vec& v )
+		{
+			return v;
+		}
+
+		static inline ci::vec3 transform( const Matrix& m, const ci::vec3& v )
+		{
+			return ci::vec3( m * ci::vec4( v, 1.0f ) );
+		}
+	};
+
+	/*
+	 * Transform math for 2D nodes, selected with 
+	 * UiTreeFeature_Transform2D. Rotation is an angle about z 
+	 * and matrices are 3x2 affine transforms, whose columns 
+	 * are the x axis, the y axis and the translation. Points 
+	 * keep their z when transformed.
+	 */
+	class Transform2D
+	{
+	public:
+		typedef glm::mat3x2 Matrix;
+		typedef float Rotation;
+		typedef ci::vec2 Vec;
+
+		static inline Matrix calcFrame( const Matrix& parent, const Vec& translate, Rotation rotation, const Vec& scale )
+		{
+			const float c = std::cos( rotation );
+			const float s = std::sin( rotation );
+			Matrix m( 1.0f );
+			m[ 0 ] = ( parent[ 0 ] * c + parent[ 1 ] * s ) * scale.x;
+			m[ 1 ] = ( parent[ 1 ] * c - parent[ 0 ] * s ) * scale.y;
+			m[ 2 ] = parent[ 0 ] * translate.x + parent[ 1 ] * translate.y + parent[ 2 ];
+			return m;
+		}
+
+		static inline Matrix calcInverse( const Matrix& m )
+		{
+			const float d = 1.0f / ( m[ 0 ].x * m[ 1 ].y - m[ 1 ].x * m[ 0 ].y );
+			Matrix r( 1.0f );
+			r[ 0 ] = ci::vec2( m[ 1 ].y, -m[ 0 ].y ) * d;
+			r[ 1 ] = ci::vec2( -m[ 1 ].x, m[ 0 ].x ) * d;
+			r[ 2 ] = -( r[ 0 ] * m[ 2 ].x + r[ 1 ] * m[ 2 ].y );
+			return r;
+		}
+
+		static inline Matrix calcScaled( const Matrix& m, const Vec& scale )
+		{
+			Matrix r = m;
+			r[ 0 ] *= scale.x;
+			r[ 1 ] *= scale.y;
+			return r;
+		}
+
+		static inline Rotation getRotation( float z )
+		{
+			return z;
+		}
+
+		// Keeps the rotation about z. Also converts rotation velocities.
+		static inline Rotation getRotation( const ci::quat& q )
+		{
+			return 2.0f * std::atan2( q.z, q.w );
+		}
+
+		static inline Rotation getRotationZero()
+		{
+			return 0.0f;
+		}
+
+		static inline Vec getVec( const ci::vec2& v )
+		{
+			return v;
+		}
+
+		static inline Vec getVec( const ci::vec3& v )
+		{
+			return ci::vec2( v );
+		}
+
+		static inline bool isFlat( const Matrix& )
+		{
+			return true;
+		}
+
+		static inline ci::vec3 toVec3( const Vec& v )
+		{
+			return ci::vec3( v, 0.0f );
+		}
+
+		static inline ci::vec3 transform( const Matrix& m, const ci::vec3& v )
+		{
+			return ci::vec3( m[ 0 ] * v.x + m[ 1 ] * v.y + m[ 2 ], v.z );
+		}
+	};
+
+	typedef typename std::conditional<( F & UiTreeFeature_Transform2D ) != 0, Transform2D, Transform3D>::type Transform;
+
+	// The types of this tree's transform channels and matrices.
+	typedef typename Transform::Matrix MatrixType;
+	typedef typename Transform::Rotation RotationType;
+	typedef typename Transform::Vec VecType;
+
+	/*
+	 * The children of a node, in ID order. Nodes can be changed 
+	 * through it, but children are only added and removed with 
+	 * addChild(), createChild() and removeChild(), which keep 
+	 * the root's index in step.
+	 */
+	class Children
+	{
+	public:
+		typedef typename std::map<uint64_t, UiTreeT<T, P, F>>::iterator iterator;
+
+		// Throws std::out_of_range if no child has this ID.
+		inline UiTreeT<T, P, F>& at( uint64_t id ) const
+		{
+			return mChildren->at( id );
+		}
+
+		inline iterator begin() const
+		{
+			return mChildren->begin();
+		}
+
+		inline size_t count( uint64_t id ) const
+		{
+			return mChildren->count( id );
+		}
+
+		inline bool empty() const
+		{
+			return mChildren->empty();
+		}
+
+		inline iterator end() const
+		{
+			return mChildren->end();
+		}
+
+		inline iterator find( uint64_t id ) const
+		{
+			return mChildren->find( id );
+		}
+
+		inline size_t size() const
+		{
+			return mChildren->size();
+		}
+	private:
+		Children( std::map<uint64_t, UiTreeT<T, P, F>>& children )
+			: mChildren( &children )
+		{
+		}
+
+		std::map<uint64_t, UiTreeT<T, P, F>>*					mChildren;
+
+		friend class UiTreeT<T, P, F>;
+	};
+
 	UiTreeT()
-	: mCollisionType( CollisionType_Rect ), mEnabled( false ), 
-	mEventHandlerDisable( nullptr ), mEventHandlerEnable( nullptr ), 
-	mEventHandlerHide( nullptr ), mEventHandlerKeyDown( nullptr ), 
-	mEventHandlerKeyUp( nullptr ), mEventHandlerMouseDown( nullptr ), 
-	mEventHandlerMouseDrag( nullptr ), mEventHandlerMouseMove( nullptr ), 
-	mEventHandlerMouseOut( nullptr ), mEventHandlerMouseOver( nullptr ), 
-	mEventHandlerMouseUp( nullptr ), mEventHandlerMouseWheel( nullptr ), 
-	mEventHandlerResize( nullptr ), mEventHandlerShow( nullptr ), 
-	mEventHandlerTouchesBegan( nullptr ), mEventHandlerTouchesEnded( nullptr ), 
-	mEventHandlerTouchesMoved( nullptr ), mEventHandlerTouchOut( nullptr ), 
-	mEventHandlerTouchOver( nullptr ), mEventHandlerUpdate( nullptr ), 
-	mId( 0 ), mMouseOver( false ), mParent( nullptr ), mRegistration( ci::vec3( 0.0f ) ), 
-	mRegistrationSpeed( 0.0f ), mRegistrationTarget( ci::vec3( 0.0f ) ), 
-	mRegistrationVelocity( ci::vec3( 0.0f ) ), mRegistrationVelocityDecay( 0.0f ), 
-	mRotationSpeed( 1.0f ), mRotationVelocityDecay( 0.0f ), 
-	mScale( ci::vec3( 1.0f ) ), mScaleSpeed( 1.0f ), mScaleTarget( ci::vec3( 1.0f ) ), 
-	mScaleVelocity( ci::vec3( 0.0f ) ), mScaleVelocityDecay( 0.0f ), 
-	mTranslate( ci::vec3( 0.0f ) ), mTranslateSpeed( 1.0f ), 
-	mTranslateTarget( ci::vec3( 0.0f ) ), mTranslateVelocity( ci::vec3( 0.0f ) ), 
-	mTranslateVelocityDecay( 0.0f ), mVisible( false )
-	{
-	}
-
-	UiTreeT( const UiTreeT& rhs )
+	: mLane( Handle_None ), mHandle( Handle_None ), mSlot( Handle_None ), mId( 0 ), mParent( nullptr ), 
+	mFrameMatrix( 1.0f ), mWorldDirty( true ), mWorldMatrix( 1.0f )
+	{
+	}
+
+	UiTreeT( const UiTreeT<T, P, F>& rhs )
+	: UiTreeT()
 	{
 		*this = rhs;
 	}
 
-	UiTreeT& operator=( const UiTreeT<T>& rhs )
-	{
-		mChildren						= rhs.mChildren;
-		mCollisionType					= rhs.mCollisionType;
-		mConnectionKeyDown				= rhs.mConnectionKeyDown;
-		mConnectionKeyUp				= rhs.mConnectionKeyUp;
-		mConnectionMouseDown			= rhs.mConnectionMouseDown;
-		mConnectionMouseDrag			= rhs.mConnectionMouseDrag;
-		mConnectionMouseMove			= rhs.mConnectionMouseMove;
-		mConnectionMouseUp				= rhs.mConnectionMouseUp;
-		mConnectionMouseWheel			= rhs.mConnectionMouseWheel;
-		mConnectionResize				= rhs.mConnectionResize;
-		mConnectionTouchesBegan			= rhs.mConnectionTouchesBegan;
-		mConnectionTouchesEnded			= rhs.mConnectionTouchesEnded;
-		mConnectionTouchesMoved			= rhs.mConnectionTouchesMoved;
-		mData							= rhs.mData;
-		mEnabled						= rhs.mEnabled;
-		mEventHandlerDisable			= rhs.mEventHandlerDisable;
-		mEventHandlerEnable				= rhs.mEventHandlerEnable;
-		mEventHandlerHide				= rhs.mEventHandlerHide;
-		mEventHandlerKeyDown			= rhs.mEventHandlerKeyDown;
-		mEventHandlerKeyUp				= rhs.mEventHandlerKeyUp;
-		mEventHandlerMouseDown			= rhs.mEventHandlerMouseDown;
-		mEventHandlerMouseDrag			= rhs.mEventHandlerMouseDrag;
-		mEventHandlerMouseMove			= rhs.mEventHandlerMouseMove;
-		mEventHandlerMouseOut			= rhs.mEventHandlerMouseOut;
-		mEventHandlerMouseOver			= rhs.mEventHandlerMouseOver;
-		mEventHandlerMouseUp			= rhs.mEventHandlerMouseUp;
-		mEventHandlerMouseWheel			= rhs.mEventHandlerMouseWheel;
-		mEventHandlerResize				= rhs.mEventHandlerResize;
-		mEventHandlerShow				= rhs.mEventHandlerShow;
-		mEventHandlerTouchesBegan		= rhs.mEventHandlerTouchesBegan;
-		mEventHandlerTouchesEnded		= rhs.mEventHandlerTouchesEnded;
-		mEventHandlerTouchesMoved		= rhs.mEventHandlerTouchesMoved;
-		mEventHandlerTouchOut			= rhs.mEventHandlerTouchOut;
-		mEventHandlerTouchOver			= rhs.mEventHandlerTouchOver;
-		mEventHandlerUpdate				= rhs.mEventHandlerUpdate;
-		mId								= rhs.mId;
-		mMouseOver						= rhs.mMouseOver;
-		mParent							= rhs.mParent;
-		mRegistration					= rhs.mRegistration;
-		mRegistrationSpeed				= rhs.mRegistrationSpeed;
-		mRegistrationTarget				= rhs.mRegistrationTarget;
-		mRegistrationVelocity			= rhs.mRegistrationVelocity;
-		mRegistrationVelocityDecay		= rhs.mRegistrationVelocityDecay;
-		mRotation						= rhs.mRotation;
-		mRotationSpeed					= rhs.mRotationSpeed;
-		mRotationTarget					= rhs.mRotationTarget;
-		mRotationVelocity				= rhs.mRotationVelocity;
-		mRotationVelocityDecay			= rhs.mRotationVelocityDecay;
-		mScale							= rhs.mScale;
-		mScaleSpeed						= rhs.mScaleSpeed;
-		mScaleTarget					= rhs.mScaleTarget;
-		mScaleVelocity					= rhs.mScaleVelocity;
-		mScaleVelocityDecay				= rhs.mScaleVelocityDecay;
-		mTouches						= rhs.mTouches;
-		mTranslate						= rhs.mTranslate;
-		mTranslateSpeed					= rhs.mTranslateSpeed;
-		mTranslateTarget				= rhs.mTranslateTarget;
-		mTranslateVelocity				= rhs.mTranslateVelocity;
-		mTranslateVelocityDecay			= rhs.mTranslateVelocityDecay;
-		mVisible						= rhs.mVisible;
+	/*
+	 * Deep copies another tree. Every copied node is linked to 
+	 * its new parent, so the copy never references the source. 
+	 * A node inside a tree keeps its own ID and parent. Throws 
+	 * ExcDuplicateId, leaving the node unchanged, if one of rhs's 
+	 * descendants has an ID used elsewhere in this node's tree. 
+	 * An enabled root copied into a root receives window events 
+	 * of its own.
+	 */
+	UiTreeT& operator=( const UiTreeT<T, P, F>& rhs )
+	{
+		if ( this == &rhs ) {
+			return *this;
+		}
+		if ( mParent != nullptr ) {
+			Registry& registry = getRegistry();
+			validateReplacementIds( registry, rhs, false );
+			registry.eraseChildSlots( *this );
+			unregisterNodes( registry );
+		}
+		disconnectSignals();
+		mRegistry.reset();
+
+		uint64_t id = mId;
+		copyFrom( rhs, nullptr );
+
+		if ( mParent == nullptr ) {
+			if ( mState.mEnabled && rhs.mParent == nullptr ) {
+				connectSignals();
+			}
+		} else {
+			mId = id;
+			registerNodes( getRegistry() );
+			getRegistry().insertChildSlots( *this );
+		}
+		return *this;
+	}
+
+	UiTreeT( UiTreeT<T, P, F>&& rhs )
+	: UiTreeT()
+	{
+		*this = std::move( rhs );
+	}
+
+	/*
+	 * Takes over the nodes of another tree. Children are relinked 
+	 * instead of copied, leaving the source empty. A node inside 
+	 * a tree keeps its own ID and parent, and throws 
+	 * ExcDuplicateId like the copy does.
+	 */
+	UiTreeT& operator=( UiTreeT<T, P, F>&& rhs )
+	{
+		if ( this == &rhs ) {
+			return *this;
+		}
+		if ( mParent != nullptr ) {
+			Registry& registry = getRegistry();
+			validateReplacementIds( registry, rhs, true );
+			registry.eraseChildSlots( *this );
+			unregisterNodes( registry );
+		}
+		disconnectSignals();
+
+		// A root taking over a root adopts its store and registry, so 
+		// no lane is copied. moveFrom() hands rhs's lane to this node.
+		bool root = mParent == nullptr;
+		mRegistry.reset();
+		if ( root && rhs.mParent == nullptr && rhs.mTransforms != nullptr ) {
+			mTransforms = std::move( rhs.mTransforms );
+		}
+		if ( root && rhs.mParent == nullptr && rhs.mRegistry != nullptr ) {
+			mRegistry						= std::move( rhs.mRegistry );
+
+			// rhs's connections capture rhs, and it can no longer reach them.
+			mRegistry->disconnectSignals();
+			mRegistry->mNodes[ rhs.mId ]	= this;
+			mRegistry->mArenaValid			= false;
+			mRegistry->releaseHandle( rhs );
+			mRegistry->acquireHandle( *this );
+			Grid::reset( *this );
+			if ( mRegistry->mSpatialIndex == SpatialIndex_Grid ) {
+				mRegistry->mGrid.erase( rhs );
+				mRegistry->mGrid.queue( *this );
+			}
+		}
+		rhs.detachChildren();
 
+		uint64_t id = mId;
+		moveFrom( rhs );
+
+		if ( root ) {
+			if ( mState.mEnabled ) {
+				connectSignals();
+			}
+		} else {
+			mId = id;
+			registerNodes( getRegistry() );
+			getRegistry().insertChildSlots( *this );
+		}
 		return *this;
 	}
 
 	~UiTreeT()
 	{
 		setEnabled( false );
+
+		// Children go first, while the path to the root whose 
+		// store holds their lanes is still intact. Links made by 
+		// setParent() may point at siblings cleared before them.
+		for ( auto& iter : mChildren ) {
+			iter.second.mParent = this;
+		}
+		mChildren.clear();
+		releaseLane();
 	}
 
+	// Returns an ID above "baseId" that no node in the tree uses, read from the root's counter.
 	inline uint64_t getNextAvailableId( uint64_t baseId = 0 ) const
 	{
-		uint64_t id = std::max<uint64_t>( baseId, mId ) + 1;
-		for ( const auto& iter : mChildren ) {
-			id = std::max<uint64_t>( id, iter.second.getNextAvailableId( id ) );
+		return std::max<uint64_t>( baseId + 1, const_cast<UiTreeT<T, P, F>*>( this )->getRegistry().mNextId );
+	}
+
+	inline UiTreeT<T, P, F>& addChild( const UiTreeT<T, P, F>& uiTree )
+	{
+		return addChild( getRegistry().acquireId(), uiTree );
+	}
+
+	inline UiTreeT<T, P, F>& addChild( uint64_t id, const UiTreeT<T, P, F>& uiTree )
+	{
+		Registry& registry = getRegistry();
+		if ( registry.mBatchDepth > 0 ) {
+			if ( mChildren.find( id ) != mChildren.end() ) {
+				throw ExcDuplicateId( id );
+			}
+		} else {
+			if ( registry.mNodes.find( id ) != registry.mNodes.end() ) {
+				throw ExcDuplicateId( id );
+			}
+			for ( const auto& iter : uiTree.mChildren ) {
+				iter.second.validateIds( registry, id );
+			}
 		}
-		return id;
+		UiTreeT<T, P, F>& child	= mChildren[ id ];
+		child.mParent			= this;
+		child.copyFrom( uiTree, nullptr );
+		child.mId				= id;
+		if ( registry.mBatchDepth > 0 ) {
+			registry.mArenaValid	= false;
+			registry.mNextId		= std::max<uint64_t>( registry.mNextId, child.calcNextId() );
+		} else {
+			child.registerNodes( registry );
+			registry.insertSlots( *this, child );
+		}
+
+		return child;
 	}
 
-	inline UiTreeT<T>& addChild( const UiTreeT<T>& uiTree )
+	inline UiTreeT<T, P, F>& addChild( UiTreeT<T, P, F>&& uiTree )
 	{
-		return addChild( getRoot()->getNextAvailableId(), uiTree );
+		return addChild( getRegistry().acquireId(), std::move( uiTree ) );
 	}
 
-	inline UiTreeT<T>& addChild( uint64_t id, const UiTreeT<T>& uiTree )
+	/*
+	 * Grafts a subtree by relinking its nodes instead of copying 
+	 * them. No node is copied, but the subtree's IDs are still 
+	 * validated and registered one by one, so the cost is linear 
+	 * in the size of the subtree.
+	 */
+	inline UiTreeT<T, P, F>& addChild( uint64_t id, UiTreeT<T, P, F>&& uiTree )
 	{
-		if ( getRoot().exists( id ) ) {
-			throw ExcDuplicateId( id );
+		Registry& registry = getRegistry();
+		if ( registry.mBatchDepth > 0 ) {
+			if ( mChildren.find( id ) != mChildren.end() ) {
+				throw ExcDuplicateId( id );
+			}
+		} else {
+			if ( registry.mNodes.find( id ) != registry.mNodes.end() ) {
+				throw ExcDuplicateId( id );
+			}
+			for ( const auto& iter : uiTree.mChildren ) {
+				iter.second.validateIds( registry, id, true );
+			}
+		}
+		uiTree.detachChildren();
+		UiTreeT<T, P, F>& child	= mChildren[ id ];
+		child.mParent			= this;
+		child.moveFrom( uiTree );
+		child.mId				= id;
+		if ( registry.mBatchDepth > 0 ) {
+			registry.mArenaValid	= false;
+			registry.mNextId		= std::max<uint64_t>( registry.mNextId, child.calcNextId() );
+		} else {
+			child.registerNodes( registry );
+			registry.insertSlots( *this, child );
 		}
-		mChildren[ id ]		= uiTree;
-		mChildren[ id ].mId = id;
-		mChildren[ id ].parent( this );
 
-		return mChildren.at( id ).parent( this );
+		return child;
 	}
 
-	inline UiTreeT<T>& addAndReturnChild( const UiTreeT<T>& uiTree )
+	inline UiTreeT<T, P, F>& addAndReturnChild( const UiTreeT<T, P, F>& uiTree )
 	{
-		return addAndReturnChild( getRoot().getNextAvailableId(), uiTree );
+		return addAndReturnChild( getRegistry().acquireId(), uiTree );
 	}
 
-	inline UiTreeT<T>& addAndReturnChild( uint64_t id, const UiTreeT<T>& uiTree )
+	inline UiTreeT<T, P, F>& addAndReturnChild( uint64_t id, const UiTreeT<T, P, F>& uiTree )
 	{
 		addChild( id, uiTree );
 		return mChildren.at( id );
 	}
 
-	inline void addChildren( const std::map<uint64_t, UiTreeT<T>>& c )
+	inline UiTreeT<T, P, F>& addAndReturnChild( UiTreeT<T, P, F>&& uiTree )
+	{
+		return addAndReturnChild( getRegistry().acquireId(), std::move( uiTree ) );
+	}
+
+	inline UiTreeT<T, P, F>& addAndReturnChild( uint64_t id, UiTreeT<T, P, F>&& uiTree )
+	{
+		addChild( id, std::move( uiTree ) );
+		return mChildren.at( id );
+	}
+
+	inline void addChildren( const std::map<uint64_t, UiTreeT<T, P, F>>& c )
 	{
 		for ( auto& iter : c ) {
 			addChild( iter.second );
 		}
 	}
 
-	inline UiTreeT<T>& createChild()
+	inline void addChildren( std::map<uint64_t, UiTreeT<T, P, F>>&& c )
+	{
+		for ( auto& iter : c ) {
+			addChild( std::move( iter.second ) );
+		}
+		c.clear();
+	}
+
+	inline UiTreeT<T, P, F>& createChild()
 	{
-		return createChild( getRoot().getNextAvailableId() );
+		return createChild( getRegistry().acquireId() );
 	}
 	
-	inline UiTreeT<T>& createChild( uint64_t id )
+	inline UiTreeT<T, P, F>& createChild( uint64_t id )
 	{
-		if ( getRoot().exists( id ) ) {
+		Registry& registry = getRegistry();
+		if ( registry.mBatchDepth > 0 ) {
+			if ( mChildren.find( id ) != mChildren.end() ) {
+				throw ExcDuplicateId( id );
+			}
+		} else if ( registry.mNodes.find( id ) != registry.mNodes.end() ) {
 			throw ExcDuplicateId( id );
 		}
-		mChildren[ id ] = UiTreeT().parent( this );
-		mChildren[ id ].mId = id;
+		UiTreeT<T, P, F>& child	= mChildren[ id ];
+		child.mId				= id;
+		child.mParent			= this;
+		if ( registry.mBatchDepth > 0 ) {
+			registry.mArenaValid	= false;
+			registry.mNextId		= std::max<uint64_t>( registry.mNextId, id + 1 );
+		} else {
+			registry.insert( child );
+			registry.insertSlots( *this, child );
+		}
 
 		return *this;
 	}
 
-	inline UiTreeT<T>& createAndReturnChild()
+	inline UiTreeT<T, P, F>& createAndReturnChild()
 	{
-		return createAndReturnChild( getRoot().getNextAvailableId() );
+		return createAndReturnChild( getRegistry().acquireId() );
 	}
 	
-	inline UiTreeT<T>& createAndReturnChild( uint64_t id )
+	inline UiTreeT<T, P, F>& createAndReturnChild( uint64_t id )
 	{
 		createChild( id );
 		return mChildren.at( id );
 	}
 
-	inline bool exists( uint64_t id ) const
+	/*
+	 * Copies a subtree under this node, giving the copy and all 
+	 * of its descendants new IDs. Use this to instantiate the 
+	 * same prefab any number of times in one tree.
+	 */
+	inline UiTreeT<T, P, F>& stampChild( const UiTreeT<T, P, F>& uiTree )
 	{
-		if ( mId == id ) {
-			return true;
-		}
-		if ( mChildren.find( id ) != mChildren.end() ) {
-			return true;
-		}
-		for ( const auto& iter : mChildren ) {
-			if ( iter.second.exists( id ) ) {
-				return true;
-			}
-		}
-		return false;
+		stampAndReturnChild( uiTree );
+		return *this;
 	}
 
-	inline UiTreeT<T>& find( uint64_t id )
+	inline UiTreeT<T, P, F>& stampAndReturnChild( const UiTreeT<T, P, F>& uiTree )
 	{
-		if ( mId == id ) {
-			return *this;
+		Registry& registry = getRegistry();
+		UiTreeT<T, P, F> clone;
+		clone.copyFrom( uiTree, &registry );
+
+		uint64_t id			= registry.acquireId();
+		UiTreeT<T, P, F>& child	= mChildren[ id ];
+		child.mParent			= this;
+		child.moveFrom( clone );
+		child.mId				= id;
+		if ( registry.mBatchDepth > 0 ) {
+			registry.mArenaValid	= false;
+			registry.mNextId		= std::max<uint64_t>( registry.mNextId, id + 1 );
+		} else {
+			child.registerNodes( registry );
+			registry.insertSlots( *this, child );
 		}
-		if ( !mChildren.empty() && mChildren.find( id ) != mChildren.end() ) {
-			return mChildren.at( id );
+		return child;
+	}
+
+	/* USAGE
+	typedef UiTreeT<UiData> UiTree;
+	...
+	mUiTree.beginBatch();
+	uint64_t id = mUiTree.reserveIds( items.size() );
+	for ( const Item& item : items ) {
+		mUiTree.createAndReturnChild( id++ ).data( UiData( item ) );
+	}
+	mUiTree.commitBatch();
+	*/
+	/*
+	 * Starts a batch on the whole tree. Until the matching 
+	 * commitBatch(), adding nodes skips the tree-wide duplicate 
+	 * check and index update. IDs are only checked against 
+	 * siblings, and nodes added during the batch cannot be 
+	 * looked up with exists() or find(). Batches may be nested.
+	 */
+	inline void beginBatch()
+	{
+		++getRegistry().mBatchDepth;
+	}
+
+	/*
+	 * Ends a batch. When the outermost batch is committed, the 
+	 * index is rebuilt in a single pass. Throws ExcDuplicateId 
+	 * if the tree contains an ID more than once. In that case, 
+	 * every subtree added during the batch is removed first, 
+	 * and the index again holds the nodes it held before.
+	 */
+	inline void commitBatch()
+	{
+		Registry& registry = getRegistry();
+		if ( registry.mBatchDepth == 0 || --registry.mBatchDepth > 0 ) {
+			return;
 		}
-		for ( auto& iter : mChildren ) {
-			if ( iter.second.exists( id ) ) {
-				return iter.second.find( id );
-			}
+		std::unordered_map<uint64_t, UiTreeT<T, P, F>*> committed;
+		std::vector<uint64_t> duplicates;
+		committed.swap( registry.mNodes );
+		registry.mArenaValid = false;
+		UiTreeT<T, P, F>& root = getRoot();
+		root.registerNodes( registry, duplicates );
+		if ( !duplicates.empty() ) {
+			root.removeBatchedNodes( registry, committed );
+			registry.mNodes.clear();
+			root.registerNodes( registry );
+			throw ExcDuplicateId( duplicates.front() );
 		}
-		throw ExcIdNotFound( id );
 	}
 
-	inline const UiTreeT<T>& find( uint64_t id ) const
+	inline bool isBatching() const
 	{
-		if ( mChildren.find( id ) != mChildren.end() ) {
-			return mChildren.at( id );
+		return const_cast<UiTreeT<T, P, F>*>( this )->getRegistry().mBatchDepth > 0;
+	}
+
+	// Reserves a contiguous range of unused IDs and returns the first one.
+	inline uint64_t reserveIds( size_t count )
+	{
+		Registry& registry	= getRegistry();
+		uint64_t id			= registry.mNextId;
+		registry.mNextId	+= count;
+		return id;
+	}
+
+	inline bool exists( uint64_t id ) const
+	{
+		return lookup( id ) != nullptr;
+	}
+
+	inline UiTreeT<T, P, F>& find( uint64_t id )
+	{
+		UiTreeT<T, P, F>* node = const_cast<UiTreeT<T, P, F>*>( lookup( id ) );
+		if ( node == nullptr ) {
+			throw ExcIdNotFound( id );
 		}
-		for ( const auto& iter : mChildren ) {
-			if ( iter.second.exists( id ) ) {
-				return iter.second.find( id );
-			}
+		return *node;
+	}
+
+	inline const UiTreeT<T, P, F>& find( uint64_t id ) const
+	{
+		const UiTreeT<T, P, F>* node = lookup( id );
+		if ( node == nullptr ) {
+			throw ExcIdNotFound( id );
 		}
-		throw ExcIdNotFound( id );
+		return *node;
 	}
 
 	/* USAGE
@@ -300,9 +910,9 @@ public:
 		CI_LOG_V( iter->getTranslate().y );
 	}
 	*/
-	inline std::list<UiTreeT<T>*> query( const std::function<bool( const UiTreeT<T>& )>& func )
+	inline std::list<UiTreeT<T, P, F>*> query( const std::function<bool( const UiTreeT<T, P, F>& )>& func )
 	{
-		std::list<UiTreeT<T>*> l;
+		std::list<UiTreeT<T, P, F>*> l;
 		if ( func( *this ) ) {
 			l.push_back( this );
 		}
@@ -312,214 +922,385 @@ public:
 		return l;
 	}
 
-	inline std::list<const UiTreeT<T>*> query( const std::function<bool( const UiTreeT<T>& )>& func ) const 
-	{
-		std::list<UiTreeT<T>*> l;
-		for ( const auto& iter : mChildren ) {
-			if ( func( iter.second ) ) {
-				l.push_back( &iter.second );
+	/*
+	 * Returns this node and its descendants whose world bounds 
+	 * overlap "rect", in preorder. Bounds are the 2D boxes used 
+	 * by the spatial index, so the result may include nodes 
+	 * whose shapes only come close to "rect". Needs 
+	 * UiTreeFeature_SpatialIndex.
+	 */
+	inline std::list<UiTreeT<T, P, F>*> query( const ci::Rectf& rect )
+	{
+		static_assert( hasFeature( UiTreeFeature_SpatialIndex ), "This tree type was built without the bounds query() reads" );
+		Registry& registry	= getArena();
+		const uint32_t end	= registry.mSlots[ mSlot ].mEnd;
+		std::list<UiTreeT<T, P, F>*> l;
+		if ( registry.mSpatialIndex == SpatialIndex_Grid ) {
+			registry.validateGrid();
+			std::vector<uint32_t> slots;
+			auto collect = [ & ]( const std::vector<UiTreeT<T, P, F>*>& nodes )
+			{
+				for ( const UiTreeT<T, P, F>* node : nodes ) {
+					if ( node->mSlot >= mSlot && node->mSlot < end && node->getSpatial()->mBounds.intersects( rect ) ) {
+						slots.push_back( node->mSlot );
+					}
+				}
+			};
+			collect( registry.mGrid.mLarge );
+			ci::ivec2 a;
+			ci::ivec2 b;
+			if ( registry.mGrid.getCells( rect, a, b ) ) {
+				for ( int32_t y = a.y; y <= b.y; ++y ) {
+					for ( int32_t x = a.x; x <= b.x; ++x ) {
+						auto iter = registry.mGrid.mCells.find( Grid::key( x, y ) );
+						if ( iter != registry.mGrid.mCells.end() ) {
+							collect( iter->second );
+						}
+					}
+				}
+			} else {
+				for ( const auto& iter : registry.mGrid.mCells ) {
+					collect( iter.second );
+				}
 			}
-			l.splice( l.end(), iter.second.query( func ) );
-		}
+
+			// Nodes spanning several cells are listed once.
+			std::sort( slots.begin(), slots.end() );
+			slots.erase( std::unique( slots.begin(), slots.end() ), slots.end() );
+			for ( uint32_t i : slots ) {
+				l.push_back( registry.mSlots[ i ].mNode );
+			}
+			return l;
+		}
+
+		const bool cull = registry.mSpatialIndex == SpatialIndex_Bvh;
+		validateBounds();
+		for ( uint32_t i = mSlot; i < end; ++i ) {
+			UiTreeT<T, P, F>* node	= registry.mSlots[ i ].mNode;
+			const Spatial* spatial	= node->getSpatial();
+			if ( cull && !spatial->mSubtreeBounds.intersects( rect ) ) {
+				i = registry.mSlots[ i ].mEnd - 1;
+				continue;
+			}
+			if ( spatial->mBounds.intersects( rect ) ) {
+				l.push_back( node );
+			}
+		}
+		return l;
+	}
+
+	inline std::list<const UiTreeT<T, P, F>*> query( const std::function<bool( const UiTreeT<T, P, F>& )>& func ) const 
+	{
+		std::list<UiTreeT<T, P, F>*> l;
+		for ( const auto& iter : mChildren ) {
+			if ( func( iter.second ) ) {
+				l.push_back( &iter.second );
+			}
+			l.splice( l.end(), iter.second.query( func ) );
+		}
 		return l;
 	}
 
 	inline bool removeChild( uint64_t id ) 
 	{
-		if ( mChildren.find( id ) != mChildren.end() ) {
-			mChildren.erase( id );
-			return true;
+		UiTreeT<T, P, F>* node = const_cast<UiTreeT<T, P, F>*>( lookup( id ) );
+		if ( node == nullptr || node == this ) {
+			return false;
 		}
-		for ( auto& iter : mChildren ) {
-			if ( iter.second.removeChild( id ) ) {
-				return true;
+
+		// Nodes reparented with setParent() still live in their original map.
+		UiTreeT<T, P, F>* owner = node->mParent;
+		if ( owner == nullptr || owner->mChildren.find( id ) == owner->mChildren.end() ) {
+			owner = getRoot().findOwner( id );
+			if ( owner == nullptr ) {
+				return false;
 			}
 		}
-		return false;
+
+		Registry& registry = getRoot().getArena();
+		if ( registry.mRelinked ) {
+			relinkParents( registry, *node );
+		}
+		registry.eraseSlots( *node );
+		node->unregisterNodes( registry );
+		owner->mChildren.erase( id );
+		owner->invalidateRoutes();
+		return true;
+	}
+
+	inline UiTreeT<T, P, F>& blur()
+	{
+		setFocused( false );
+		return *this;
 	}
 
-	inline UiTreeT<T>& children( const std::map<uint64_t, UiTreeT<T>>& c )
+	inline UiTreeT<T, P, F>& children( const std::map<uint64_t, UiTreeT<T, P, F>>& c )
 	{
 		setChildren( c );
 		return *this;
 	}
 
-	inline UiTreeT<T>& collisionType( CollisionType t )
+	inline UiTreeT<T, P, F>& children( std::map<uint64_t, UiTreeT<T, P, F>>&& c )
+	{
+		setChildren( std::move( c ) );
+		return *this;
+	}
+
+	inline UiTreeT<T, P, F>& collisionType( CollisionType t )
 	{
 		setCollisionType( t );
 		return *this;
 	}
 
-	inline UiTreeT<T>& data( const T& d )
+	inline UiTreeT<T, P, F>& data( const T& d )
 	{
 		setData( d );
 		return *this;
 	}
 
-	inline UiTreeT<T>& disable()
+	inline UiTreeT<T, P, F>& disable()
 	{
 		setEnabled( false );
 		return *this;
 	}
 
-	inline UiTreeT<T>& enable( bool enabled = true )
+	inline UiTreeT<T, P, F>& enable( bool enabled = true )
 	{
 		setEnabled( enabled );
 		return *this;
 	}
 
-	inline UiTreeT<T>& hide()
+	inline UiTreeT<T, P, F>& fixedTimestep( double seconds )
+	{
+		setFixedTimestep( seconds );
+		return *this;
+	}
+
+	inline UiTreeT<T, P, F>& focus()
+	{
+		setFocused( true );
+		return *this;
+	}
+
+	inline UiTreeT<T, P, F>& focusable( bool focusable = true )
+	{
+		setFocusable( focusable );
+		return *this;
+	}
+
+	inline UiTreeT<T, P, F>& focusScope( bool scope = true )
+	{
+		setFocusScope( scope );
+		return *this;
+	}
+
+	inline UiTreeT<T, P, F>& hide()
 	{
 		setVisible( false );
 		return *this;
 	}
 
-	inline UiTreeT<T>& parent( UiTreeT<T>* uiTree )
+	inline UiTreeT<T, P, F>& idRecycling( bool enabled = true )
+	{
+		setIdRecyclingEnabled( enabled );
+		return *this;
+	}
+
+	inline UiTreeT<T, P, F>& inputMode( InputMode mode )
+	{
+		setInputMode( mode );
+		return *this;
+	}
+
+	inline UiTreeT<T, P, F>& parent( UiTreeT<T, P, F>* uiTree )
 	{
 		setParent( uiTree );
 		return *this;
 	}
 
-	inline UiTreeT<T>& visible( bool isVisible = true )
+	inline UiTreeT<T, P, F>& spatialGridCellSize( float size )
+	{
+		setSpatialGridCellSize( size );
+		return *this;
+	}
+
+	inline UiTreeT<T, P, F>& spatialIndex( SpatialIndex index )
+	{
+		setSpatialIndex( index );
+		return *this;
+	}
+
+	inline UiTreeT<T, P, F>& updateMode( UpdateMode mode )
+	{
+		setUpdateMode( mode );
+		return *this;
+	}
+
+	inline UiTreeT<T, P, F>& visible( bool isVisible = true )
 	{
 		setVisible( isVisible );
 		return *this;
 	}
 
-	inline UiTreeT<T>& show()
+	inline UiTreeT<T, P, F>& show()
 	{
 		setVisible( true );
 		return *this;
 	}
 
-	inline ci::mat4 calcModelMatrix() const
+	// Returns this node's local transform.
+	inline MatrixType calcModelMatrix() const
+	{
+		TransformStore& store	= getTransforms();
+		const uint32_t lane		= getLane( store );
+		return Transform::calcScaled( Transform::calcFrame( MatrixType( 1.0f ), 
+			store.mTranslate.mValue.get( lane ) - store.mRegistration.mValue.get( lane ), 
+			store.mRotation.mValue.get( lane ), store.mGroupScale.mValue.get( lane ) ), store.mScale.mValue.get( lane ) );
+	}
+
+	inline UiTreeT<T, P, F>& groupScale( const ci::vec2& v, float speed = 1.0f )
+	{
+		setGroupScale( v, speed );
+		return *this;
+	}
+
+	inline UiTreeT<T, P, F>& groupScale( const ci::vec3& v, float speed = 1.0f )
+	{
+		setGroupScale( v, speed );
+		return *this;
+	}
+
+	inline UiTreeT<T, P, F>& groupScaleVelocity( const ci::vec2& v, float decay = 1.0f )
+	{
+		setGroupScaleVelocity( v, decay );
+		return *this;
+	}
+
+	inline UiTreeT<T, P, F>& groupScaleVelocity( const ci::vec3& v, float decay = 1.0f )
 	{
-		ci::mat4 m( 1.0f );
-		m = glm::translate( m, mTranslate - mRegistration );
-		m *= glm::toMat4( mRotation );
-		m = glm::scale( m, mScale );
-		return m;
+		setGroupScaleVelocity( v, decay );
+		return *this;
 	}
 
-	inline UiTreeT<T>& registration( const ci::vec2& v, float speed = 1.0f )
+	inline UiTreeT<T, P, F>& registration( const ci::vec2& v, float speed = 1.0f )
 	{
 		setRegistration( v, speed );
 		return *this;
 	}
 
-	inline UiTreeT<T>& registration( const ci::vec3& v, float speed = 1.0f )
+	inline UiTreeT<T, P, F>& registration( const ci::vec3& v, float speed = 1.0f )
 	{
 		setRegistration( v, speed );
 		return *this;
 	}
 
-	inline UiTreeT<T>& registrationVelocity( const ci::vec2& v, float decay = 1.0f )
+	inline UiTreeT<T, P, F>& registrationVelocity( const ci::vec2& v, float decay = 1.0f )
 	{
 		setRegistrationVelocity( v, decay );
 		return *this;
 	}
 
-	inline UiTreeT<T>& registrationVelocity( const ci::vec3& v, float decay = 1.0f )
+	inline UiTreeT<T, P, F>& registrationVelocity( const ci::vec3& v, float decay = 1.0f )
 	{
 		setRegistrationVelocity( v, decay );
 		return *this;
 	}
 
-	inline UiTreeT<T>& rotate( float z, float speed = 1.0f )
+	inline UiTreeT<T, P, F>& rotate( float z, float speed = 1.0f )
 	{
 		setRotation( z, speed );
 		return *this;
 	}
 
-	inline UiTreeT<T>& rotate( const ci::quat& q, float speed = 1.0f )
+	inline UiTreeT<T, P, F>& rotate( const ci::quat& q, float speed = 1.0f )
 	{
 		setRotation( q, speed );
 		return *this;
 	}
 
-	inline UiTreeT<T>& rotationVelocity( float z, float decay = 1.0f )
+	inline UiTreeT<T, P, F>& rotationVelocity( float z, float decay = 1.0f )
 	{
 		setRotationVelocity( z, decay );
 		return *this;
 	}
 
-	inline UiTreeT<T>& rotationVelocity( const ci::quat& q, float decay = 1.0f )
+	inline UiTreeT<T, P, F>& rotationVelocity( const ci::quat& q, float decay = 1.0f )
 	{
 		setRotationVelocity( q, decay );
 		return *this;
 	}
 
-	inline UiTreeT<T>& scale( const ci::vec2& v, float speed = 1.0f )
+	inline UiTreeT<T, P, F>& scale( const ci::vec2& v, float speed = 1.0f )
 	{
 		setScale( v, speed );
 		return *this;
 	}
 
-	inline UiTreeT<T>& scale( const ci::vec3& v, float speed = 1.0f )
+	inline UiTreeT<T, P, F>& scale( const ci::vec3& v, float speed = 1.0f )
 	{
 		setScale( v, speed );
 		return *this;
 	}
 
-	inline UiTreeT<T>& scaleVelocity( const ci::vec2& v, float decay = 1.0f )
+	inline UiTreeT<T, P, F>& scaleVelocity( const ci::vec2& v, float decay = 1.0f )
 	{
 		setScaleVelocity( v, decay );
 		return *this;
 	}
 
-	inline UiTreeT<T>& scaleVelocity( const ci::vec3& v, float decay = 1.0f )
+	inline UiTreeT<T, P, F>& scaleVelocity( const ci::vec3& v, float decay = 1.0f )
 	{
 		setScaleVelocity( v, decay );
 		return *this;
 	}
 
-	inline UiTreeT<T>& translate( const ci::vec2& v, float speed = 1.0f )
+	inline UiTreeT<T, P, F>& translate( const ci::vec2& v, float speed = 1.0f )
 	{
 		setTranslate( v, speed );
 		return *this;
 	}
 
-	inline UiTreeT<T>& translate( const ci::vec3& v, float speed = 1.0f )
+	inline UiTreeT<T, P, F>& translate( const ci::vec3& v, float speed = 1.0f )
 	{
 		setTranslate( v, speed );
 		return *this;
 	}
 
-	inline UiTreeT<T>& translateVelocity( const ci::vec2& v, float decay = 1.0f )
+	inline UiTreeT<T, P, F>& translateVelocity( const ci::vec2& v, float decay = 1.0f )
 	{
 		setTranslateVelocity( v, decay );
 		return *this;
 	}
 
-	inline UiTreeT<T>& translateVelocity( const ci::vec3& v, float decay = 1.0f )
+	inline UiTreeT<T, P, F>& translateVelocity( const ci::vec3& v, float decay = 1.0f )
 	{
 		setTranslateVelocity( v, decay );
 		return *this;
 	}
 
-	inline std::map<uint64_t, UiTreeT<T>>& getChildren()
+	inline Children getChildren()
 	{
-		return mChildren;
+		return Children( mChildren );
 	}
 
-	inline const std::map<uint64_t, UiTreeT<T>>& getChildren() const
+	inline const std::map<uint64_t, UiTreeT<T, P, F>>& getChildren() const
 	{
 		return mChildren;
 	}
 
 	inline CollisionType getCollisionType() const
 	{
-		return mCollisionType;
+		return mState.mCollisionType;
 	}
 
 	inline T& getData()
 	{
-		return mData;
+		return mState.mData;
 	}
 
 	inline const T& getData() const
 	{
-		return mData;
+		return mState.mData;
 	}
 
 	inline uint64_t getId() const
@@ -527,1147 +1308,5118 @@ public:
 		return mId;
 	}
 	
-	inline UiTreeT<T>* getParent()
+	// Returns the node holding keyboard focus in this node's tree, or nullptr.
+	inline UiTreeT<T, P, F>* getFocusedNode()
 	{
-		return mParent;
+		Registry& registry	= getRegistry();
+		RootInput* input	= registry.getInput();
+		if ( input == nullptr ) {
+			return nullptr;
+		}
+		auto iter			= registry.mNodes.find( input->mFocusId );
+		return iter == registry.mNodes.end() ? nullptr : iter->second;
 	}
 
-	inline const UiTreeT<T>* getParent() const
+	inline const UiTreeT<T, P, F>* getFocusedNode() const
 	{
-		return mParent;
+		return const_cast<UiTreeT<T, P, F>*>( this )->getFocusedNode();
 	}
 
-	inline UiTreeT<T>& getRoot()
+	inline UiTreeT<T, P, F>* getParent()
 	{
-		return mParent == nullptr ? *this : mParent->getRoot();
+		return mParent;
 	}
 
-	inline const UiTreeT<T>& getRoot() const
+	inline const UiTreeT<T, P, F>* getParent() const
 	{
-		return mParent == nullptr ? *this : mParent->getRoot();
+		return mParent;
 	}
 
-	inline const std::vector<ci::app::TouchEvent::Touch>& getTouches() const
-	{
-		return mTouches;
-	}
-	
-	inline bool hasTouches() const
+	inline UiTreeT<T, P, F>& getRoot()
 	{
-		return !mTouches.empty();
+		return mParent == nullptr ? *this : mParent->getRoot();
 	}
 
-	inline bool isEnabled() const
+	inline const UiTreeT<T, P, F>& getRoot() const
 	{
-		return mEnabled;
+		return mParent == nullptr ? *this : mParent->getRoot();
 	}
 
-	inline bool isMouseOver() const
+	inline double getFixedTimestep() const
 	{
-		return mMouseOver;
+		return const_cast<UiTreeT<T, P, F>*>( this )->getRegistry().mFixedTimestep;
 	}
 
-	inline bool isVisible() const
+	inline InputMode getInputMode() const
 	{
-		return mVisible;
+		const RootInput* input = getRootInput();
+		return input == nullptr ? InputMode_Immediate : input->mInputMode;
 	}
 
-	inline bool contains( const ci::vec2& v, CollisionType t = CollisionType_Rect, uint64_t* id = nullptr ) const
+	/*
+	 * Returns the positions of the mouse events merged into the 
+	 * move or drag being dispatched, oldest first. Empty unless 
+	 * the input mode is InputMode_Samples.
+	 */
+	inline const std::vector<ci::vec2>& getMouseSamples() const
 	{
-		return contains( ci::vec3( v, 0.0f ), t, id );
+		static const std::vector<ci::vec2> empty;
+		const RootInput* input = getRootInput();
+		return input == nullptr ? empty : input->mMouseSamples;
 	}
 
-	inline bool contains( const ci::vec3& v, CollisionType t = CollisionType_Cube, uint64_t* id = nullptr ) const
+	// Returns the merged positions of the touch "touchId", like getMouseSamples().
+	inline const std::vector<ci::vec2>& getTouchSamples( uint32_t touchId ) const
 	{
-		const ci::vec3& p = mTranslate - mRegistration;
-		bool hit = false;
-		switch ( t ) {
-		case CollisionType_Circle:
-			hit = glm::distance( ci::vec2( p ), ci::vec2( v ) ) < std::min( mScale.x, mScale.y );
-			break;
-		case CollisionType_Cube:
-			hit = ci::AxisAlignedBox( p - mScale * 0.5f, p + mScale * 0.5f ).contains( v );
-			break;
-		case CollisionType_Rect:
-			hit = ci::Rectf( ci::vec2( p ), ci::vec2( p ) + ci::vec2( mScale ) ).contains( ci::vec2( v ) );
-			break;
-		case CollisionType_Sphere:
-			hit = glm::distance( p, v ) < std::min( mScale.x, std::min( mScale.y, mScale.z ) );
-			break;
+		static const std::vector<ci::vec2> empty;
+		const RootInput* input = getRootInput();
+		if ( input == nullptr ) {
+			return empty;
 		}
-		if ( hit ) {
-			if ( id != nullptr ) {
-				*id = mId;
-			}
-			return true;
-		}
-		for ( const std::pair<uint64_t, UiTreeT<T>>& iter : mChildren ) {
-			if ( iter.second.contains( v - p, t, id ) ) {
-				return true;
-			}
-		}
-		return false;
+		auto iter = input->mTouchSamples.find( touchId );
+		return iter == input->mTouchSamples.end() ? empty : iter->second;
 	}
 
-	inline const ci::vec3& getRegistration() const
+	inline float getSpatialGridCellSize() const
 	{
-		return mRegistration;
+		return const_cast<UiTreeT<T, P, F>*>( this )->getRegistry().mGrid.mCellSize;
 	}
 
-	inline float getRegistrationSpeed() const
+	inline SpatialIndex getSpatialIndex() const
 	{
-		return mRegistrationSpeed;
+		return const_cast<UiTreeT<T, P, F>*>( this )->getRegistry().mSpatialIndex;
 	}
 
-	inline const ci::vec3& getRegistrationTarget() const
+	inline UpdateMode getUpdateMode() const
 	{
-		return mRegistrationTarget;
+		return const_cast<UiTreeT<T, P, F>*>( this )->getRegistry().mUpdateMode;
 	}
 
-	inline const ci::vec3& getRegistrationVelocity() const
+	// Returns this node's handle, or Handle_None while it waits for a batch to commit.
+	inline Handle getHandle()
 	{
-		return mRegistrationVelocity;
+		getRegistry();
+		return mHandle;
 	}
 
-	inline float getRegistrationVelocityDecay() const
+	/*
+	 * Returns the node "handle" refers to. Throws ExcInvalidHandle 
+	 * if that node has left the tree, even if another node has 
+	 * since taken its entry in the handle table.
+	 */
+	inline UiTreeT<T, P, F>& getNode( Handle handle )
 	{
-		return mRegistrationVelocityDecay;
+		UiTreeT<T, P, F>* node = getRegistry().resolve( handle );
+		if ( node == nullptr ) {
+			throw ExcInvalidHandle( handle );
+		}
+		return *node;
 	}
 
-	inline const ci::quat& getRotation() const
+	inline Handle getFirstChildHandle( Handle handle )
 	{
-		return mRotation;
+		Registry& registry	= getArena();
+		const uint32_t slot	= getNode( handle ).mSlot;
+		return slot + 1 < registry.mSlots[ slot ].mEnd ? registry.mSlots[ slot + 1 ].mNode->mHandle : Handle_None;
 	}
 
-	inline float getRotationSpeed() const
+	inline Handle getNextSiblingHandle( Handle handle )
 	{
-		return mRotationSpeed;
+		Registry& registry		= getArena();
+		const uint32_t slot		= getNode( handle ).mSlot;
+		const uint32_t parent	= registry.mSlots[ slot ].mParent;
+		const uint32_t next		= registry.mSlots[ slot ].mEnd;
+		return parent != Handle_None && next < registry.mSlots[ parent ].mEnd ? registry.mSlots[ next ].mNode->mHandle : Handle_None;
 	}
 
-	inline const ci::quat& getRotationTarget() const
+	inline Handle getParentHandle( Handle handle )
 	{
-		return mRotationTarget;
+		Registry& registry		= getArena();
+		const uint32_t parent	= registry.mSlots[ getNode( handle ).mSlot ].mParent;
+		return parent == Handle_None ? Handle_None : registry.mSlots[ parent ].mNode->mHandle;
 	}
 
-	inline const ci::quat& getRotationVelocity() const
+	/*
+	 * Returns the touches currently over this node or one of its 
+	 * descendants. The root refills the list once per touch event, 
+	 * so it stays valid until the next one or until the node 
+	 * leaves the tree.
+	 */
+	inline const std::vector<ci::app::TouchEvent::Touch>& getTouches() const
 	{
-		return mRotationVelocity;
+		static const std::vector<ci::app::TouchEvent::Touch> none;
+		const RootInput* input = getRootInput();
+		if ( input != nullptr ) {
+			auto iter = input->mNodeTouches.find( mId );
+			if ( iter != input->mNodeTouches.end() ) {
+				return iter->second;
+			}
+		}
+		return none;
 	}
-
-	inline float getRotationVelocityDecay() const
+	
+	inline bool hasPointerCapture() const
 	{
-		return mRotationVelocityDecay;
+		const RootInput* input = getRootInput();
+		return input != nullptr && input->mPointerCaptureId == mId;
 	}
 
-	inline const ci::vec3& getScale() const
+	inline bool hasPointerCapture( uint32_t touchId ) const
 	{
-		return mScale;
+		const RootInput* input = getRootInput();
+		if ( input == nullptr ) {
+			return false;
+		}
+		auto iter = input->mTouchCaptureIds.find( touchId );
+		return iter != input->mTouchCaptureIds.end() && iter->second == mId;
 	}
 
-	inline float getScaleSpeed() const
+	// Returns true if this node has captured any touch.
+	inline bool hasTouchCapture() const
 	{
-		return mScaleSpeed;
+		const RootInput* input = getRootInput();
+		if ( input != nullptr ) {
+			for ( const auto& iter : input->mTouchCaptureIds ) {
+				if ( iter.second == mId ) {
+					return true;
+				}
+			}
+		}
+		return false;
 	}
 
-	inline const ci::vec3& getScaleTarget() const
-	{
-		return mScaleTarget;
-	}
-	
-	inline const ci::vec3& getScaleVelocity() const
-	{
-		return mScaleVelocity;
-	}
-	
-	inline float getScaleVelocityDecay() const
+	inline bool hasTouches() const
 	{
-		return mScaleVelocityDecay;
+		return !getTouches().empty();
 	}
 
-	inline const ci::vec3& getTranslate() const
+	inline bool isEnabled() const
 	{
-		return mTranslate;
+		return mState.mEnabled;
 	}
 
-	inline float getTranslateSpeed() const
+	inline bool isFocusable() const
 	{
-		return mTranslateSpeed;
+		const Input* input = getInput();
+		return input != nullptr && input->mFocusable;
 	}
 
-	inline const ci::vec3& getTranslateTarget() const
-	{
-		return mTranslateTarget;
-	}
-	
-	inline const ci::vec3& getTranslateVelocity() const
-	{
-		return mTranslateVelocity;
-	}
-	
-	inline float getTranslateVelocityDecay() const
+	inline bool isFocused() const
 	{
-		return mTranslateVelocityDecay;
+		return getFocusedNode() == this;
 	}
 
-	inline ci::vec3 calcAbsoluteTranslate() const
+	inline bool isFocusScope() const
 	{
-		ci::vec3 p						= mTranslate;
-		const UiTreeT<T>* parent	= mParent;
-		while ( parent != nullptr ) {
-			p						+= parent->getTranslate();
-			parent					= parent->getParent();
-		}
-		return p;
+		const Input* input = getInput();
+		return input != nullptr && input->mFocusScope;
 	}
 
-	// Calculates the total number of nodes in this tree and its children.
-	inline size_t calcNumNodes() const
+	// Returns true if IDs of removed nodes are reused by the tree's default ID assignment.
+	inline bool isIdRecyclingEnabled() const
 	{
-		return calcNumNodes( 0 );
+		return const_cast<UiTreeT<T, P, F>*>( this )->getRegistry().mRecycleIds;
 	}
 
-	inline void setChildren( const std::map<uint64_t, UiTreeT<T>>& c )
+	inline bool isMouseOver() const
 	{
-		mChildren.clear();
-		addChildren( c );
+		const Input* input = getInput();
+		return input != nullptr && input->mMouseOver;
 	}
 
-	inline void setCollisionType( CollisionType t )
+	inline bool isVisible() const
 	{
-		mCollisionType = t;
+		return mState.mVisible;
 	}
 
-	inline void setData( const T& d )
+	inline bool contains( const ci::vec2& v, CollisionType t = CollisionType_Rect, uint64_t* id = nullptr ) const
 	{
-		mData = d;
+		return contains( ci::vec3( v, 0.0f ), t, id );
 	}
 
-	inline void setEnabled( bool enabled )
+	/*
+	 * Returns true if the world space point "v" hits this node 
+	 * or one of its descendants, testing parents before their 
+	 * children. The point is carried into each node's local 
+	 * frame with its cached inverse world transform, so 
+	 * rotation and registration up the tree are respected. 
+	 * Shapes are sized by the node's scale: "Rect" spans the 
+	 * origin to scale, "Cube" is centered on the origin, and 
+	 * "Circle" and "Sphere" use the smallest scale component 
+	 * as their radius.
+	 */
+	inline bool contains( const ci::vec3& v, CollisionType t = CollisionType_Cube, uint64_t* id = nullptr ) const
 	{
-		bool prev	= mEnabled;
-		mEnabled	= enabled;
-		if ( prev != mEnabled ) {
-			if ( mEnabled ) {
-				ci::app::WindowRef window = ci::app::getWindow();
-				if ( mParent == nullptr && window != nullptr ) {
-					mConnectionKeyDown = window->getSignalKeyDown().connect( 1, 
-						[ this ]( ci::app::KeyEvent& event ) { keyDown( event ); } );
-					mConnectionKeyUp = window->getSignalKeyUp().connect( 1, 
-						[ this ]( ci::app::KeyEvent& event ) { keyUp( event ); } );
-					mConnectionMouseDown = window->getSignalMouseDown().connect( 1, 
-						[ this ]( ci::app::MouseEvent& event ) { mouseDown( event ); } );
-					mConnectionMouseDrag = window->getSignalMouseDrag().connect( 1, 
-						[ this ]( ci::app::MouseEvent& event ) { mouseDrag( event ); } );
-					mConnectionMouseMove = window->getSignalMouseMove().connect( 1, 
-						[ this ]( ci::app::MouseEvent& event ) { mouseMove( event ); } );
-					mConnectionMouseUp = window->getSignalMouseUp().connect( 1, 
-						[ this ]( ci::app::MouseEvent& event ) { mouseUp( event ); } );
-					mConnectionMouseWheel = window->getSignalMouseWheel().connect( 1, 
-						[ this ]( ci::app::MouseEvent& event ) { mouseWheel( event ); } );
-					mConnectionResize = window->getSignalResize().connect( 1, 
-						[ this ]() { resize(); } );
-					mConnectionTouchesBegan = window->getSignalTouchesBegan().connect( 1, 
-						[ this ]( ci::app::TouchEvent& event ) { touchesBegan( event ); } );
-					mConnectionTouchesEnded = window->getSignalTouchesEnded().connect( 1, 
-						[ this ]( ci::app::TouchEvent& event ) { touchesEnded( event ); } );
-					mConnectionTouchesMoved = window->getSignalTouchesMoved().connect( 1, 
-						[ this ]( ci::app::TouchEvent& event ) { touchesMoved( event ); } );
-				}
-				if ( mEventHandlerEnable != nullptr ) {
-					mEventHandlerEnable( this );
+		Registry& registry	= const_cast<UiTreeT<T, P, F>*>( this )->getArena();
+		const uint32_t end	= registry.mSlots[ mSlot ].mEnd;
+		if ( registry.mSpatialIndex == SpatialIndex_Bvh ) {
+			validateBounds();
+		}
+		const uint32_t hit = calcFirstHit( registry, mSlot, end, v, &t );
+		if ( hit == end ) {
+			return false;
+		}
+		if ( id != nullptr ) {
+			*id = registry.mSlots[ hit ].mNode->mId;
+		}
+		return true;
+	}
+
+	/*
+	 * Resolves a batch of world space points in a single pass 
+	 * over this subtree. Each entry of "ids" receives the ID 
+	 * that contains() would report for the matching point, or 
+	 * Id_None. Node bounds are tested against four points at 
+	 * a time, and points drop out of the batch once they hit. 
+	 * Without UiTreeFeature_SpatialIndex, every node is tested 
+	 * against every point left. Returns the number of points 
+	 * that hit.
+	 */
+	inline size_t hitTest( const std::vector<ci::vec2>& points, std::vector<uint64_t>& ids, 
+		CollisionType t = CollisionType_Rect ) const
+	{
+		ids.assign( points.size(), Id_None );
+		Registry& registry	= const_cast<UiTreeT<T, P, F>*>( this )->getArena();
+		const uint32_t end	= registry.mSlots[ mSlot ].mEnd;
+		PointBatch& batch	= registry.mPoints;
+		batch.clear();
+		for ( size_t i = 0; i < points.size(); ++i ) {
+			batch.push_back( points[ i ], i );
+		}
+		validateBounds();
+
+		size_t hits = 0;
+		for ( uint32_t i = mSlot; i < end && !batch.mIndex.empty(); ++i ) {
+			const UiTreeT<T, P, F>& node	= *registry.mSlots[ i ].mNode;
+			const Spatial* spatial			= node.getSpatial();
+			if ( spatial != nullptr ) {
+				if ( batch.contains( spatial->mSubtreeBounds ) == 0 ) {
+					i = registry.mSlots[ i ].mEnd - 1;
+					continue;
 				}
-			} else {
-				if ( mParent == nullptr ) {
-					mConnectionKeyDown.disconnect();
-					mConnectionKeyUp.disconnect();
-					mConnectionMouseDown.disconnect();
-					mConnectionMouseDrag.disconnect();
-					mConnectionMouseMove.disconnect();
-					mConnectionMouseUp.disconnect();
-					mConnectionMouseWheel.disconnect();
-					mConnectionResize.disconnect();
-					mConnectionTouchesBegan.disconnect();
-					mConnectionTouchesEnded.disconnect();
-					mConnectionTouchesMoved.disconnect();
+				if ( batch.contains( spatial->mBounds ) == 0 ) {
+					continue;
 				}
-				if ( mEventHandlerDisable != nullptr ) {
-					mEventHandlerDisable( this );
+			} else {
+				batch.mMask.assign( batch.mIndex.size(), 1 );
+			}
+			const MatrixType inverse = node.getInverseFrameMatrix( registry.mTransforms );
+
+			// Walks backward so erased points are replaced by ones already tested.
+			for ( size_t j = batch.mIndex.size(); j-- > 0; ) {
+				if ( batch.mMask[ j ] != 0 && node.intersects( registry.mTransforms, 
+					Transform::transform( inverse, ci::vec3( batch.mX[ j ], batch.mY[ j ], 0.0f ) ), t ) ) {
+					ids[ batch.mIndex[ j ] ] = node.mId;
+					batch.erase( j );
+					++hits;
 				}
 			}
 		}
+		return hits;
 	}
 
-	inline void setParent( UiTreeT<T>* uiTree )
+	inline VecType getGroupScale() const
 	{
-		mParent = uiTree;
+		return getLaneValue( &TransformStore::mGroupScale );
 	}
 
-	inline void setVisible( bool visible )
+	inline float getGroupScaleSpeed() const
 	{
-		bool prev	= mVisible;
-		mVisible	= visible;
-		if ( prev != mVisible ) {
-			if ( mVisible && mEventHandlerShow != nullptr ) {
-				mEventHandlerShow( this );
-			} else if ( !mVisible && mEventHandlerHide != nullptr ) {
-				mEventHandlerHide( this );
-			}
-		}
+		return getLaneSpeed( &TransformStore::mGroupScale );
 	}
 
-	inline void setRegistration( const ci::vec2& v, float speed = 1.0f )
+	inline VecType getGroupScaleTarget() const
 	{
-		setRegistration( ci::vec3( v, 0.0f ), speed );
+		return getLaneTarget( &TransformStore::mGroupScale );
 	}
 
-	inline void setRegistration( const ci::vec3& v, float speed = 1.0f )
+	inline VecType getGroupScaleVelocity() const
 	{
-		mRegistrationSpeed		= speed;
-		mRegistrationTarget		= v;
-		mRegistrationVelocity	= ci::vec3( 0.0f );
-		mRegistrationVelocityDecay	= 0.0f;
-		if ( speed >= 1.0f ) {
-			mRegistration		= mRegistrationTarget;
-		}
+		return getLaneVelocity( &TransformStore::mGroupScale, VecType( 0.0f ) );
 	}
 
-	inline void setRegistrationVelocity( const ci::vec2& v, float decay = 1.0f )
+	inline float getGroupScaleVelocityDecay() const
 	{
-		setRegistrationVelocity( ci::vec3( v, 0.0f ), decay );
+		return getLaneVelocityDecay( &TransformStore::mGroupScale );
 	}
 
-	inline void setRegistrationVelocity( const ci::vec3& v, float decay = 1.0f )
+	inline VecType getRegistration() const
 	{
-		mRegistrationSpeed			= 1.0f;
-		mRegistrationTarget			= mRegistration;
-		mRegistrationVelocity		= v;
-		mRegistrationVelocityDecay	= decay;
+		return getLaneValue( &TransformStore::mRegistration );
 	}
 
-	inline void setRotation( float z, float speed = 1.0f )
+	inline float getRegistrationSpeed() const
 	{
-		mRotationSpeed	= speed;
-		mRotationTarget = glm::angleAxis( z, ci::vec3( 0.0f, 0.0f, 1.0f ) );
+		return getLaneSpeed( &TransformStore::mRegistration );
 	}
 
-	inline void setRotation( const ci::quat& q, float speed = 1.0f )
+	inline VecType getRegistrationTarget() const
 	{
-		mRotationSpeed	= speed;
-		mRotationTarget = q;
+		return getLaneTarget( &TransformStore::mRegistration );
 	}
 
-	inline void setRotationVelocity( float z, float decay = 1.0f )
+	inline VecType getRegistrationVelocity() const
 	{
-		setRotationVelocity( glm::angleAxis( z, ci::vec3( 0.0f, 0.0f, 1.0f ) ), decay );
+		return getLaneVelocity( &TransformStore::mRegistration, VecType( 0.0f ) );
 	}
 
-	inline void setRotationVelocity( const ci::quat& q, float decay = 1.0f )
+	inline float getRegistrationVelocityDecay() const
 	{
-		mRotationSpeed			= 1.0f;
-		mRotationTarget			= mRotation;
-		mRotationVelocity		= q;
-		mRotationVelocityDecay	= decay;
+		return getLaneVelocityDecay( &TransformStore::mRegistration );
 	}
 
-	inline void setScale( const ci::vec2& v, float speed = 1.0f )
+	inline RotationType getRotation() const
 	{
-		setScale( ci::vec3( v, 0.0f ), speed );
+		return getLaneValue( &TransformStore::mRotation );
 	}
 
-	inline void setScale( const ci::vec3& v, float speed = 1.0f )
+	inline float getRotationSpeed() const
 	{
-		mScaleSpeed		= speed;
-		mScaleTarget	= v;
-		mScaleVelocity	= ci::vec3( 0.0f );
-		mScaleVelocityDecay	= 0.0f;
-		if ( speed >= 1.0f ) {
-			mScale		= mScaleTarget;
-		}
+		return getLaneSpeed( &TransformStore::mRotation );
 	}
 
-	inline void setScaleVelocity( const ci::vec2& v, float decay = 1.0f )
+	inline RotationType getRotationTarget() const
 	{
-		setScaleVelocity( ci::vec3( v, 0.0f ), decay );
+		return getLaneTarget( &TransformStore::mRotation );
 	}
 
-	inline void setScaleVelocity( const ci::vec3& v, float decay = 1.0f )
+	inline RotationType getRotationVelocity() const
 	{
-		mScaleSpeed			= 1.0f;
-		mScaleTarget		= mScale;
-		mScaleVelocity		= v;
-		mScaleVelocityDecay	= decay;
+		return getLaneVelocity( &TransformStore::mRotation, Transform::getRotationZero() );
 	}
 
-	inline void setTranslate( const ci::vec2& v, float speed = 1.0f )
+	inline float getRotationVelocityDecay() const
 	{
-		setTranslate( ci::vec3( v, 0.0f ), speed );
+		return getLaneVelocityDecay( &TransformStore::mRotation );
 	}
 
-	inline void setTranslate( const ci::vec3& v, float speed = 1.0f )
+	inline VecType getScale() const
 	{
-		mTranslateSpeed		= speed;
-		mTranslateTarget	= v;
-		mTranslateVelocity	= ci::vec3( 0.0f );
-		mTranslateVelocityDecay	= 0.0f;
-		if ( speed >= 1.0f ) {
-			mTranslate		= mTranslateTarget;
-		}
+		return getLaneValue( &TransformStore::mScale );
 	}
 
-	inline void setTranslateVelocity( const ci::vec2& v, float decay = 1.0f )
+	inline float getScaleSpeed() const
 	{
-		setTranslateVelocity( ci::vec3( v, 0.0f ), decay );
+		return getLaneSpeed( &TransformStore::mScale );
 	}
 
-	inline void setTranslateVelocity( const ci::vec3& v, float decay = 1.0f )
+	inline VecType getScaleTarget() const
 	{
-		mTranslateSpeed			= 1.0f;
-		mTranslateTarget		= mTranslate;
-		mTranslateVelocity		= v;
-		mTranslateVelocityDecay	= decay;
+		return getLaneTarget( &TransformStore::mScale );
 	}
 
-	inline UiTreeT<T>& connectDisableEventHandler( const std::function<void( UiTreeT<T>* )>& eventHandler )
+	inline VecType getScaleVelocity() const
 	{
-		mEventHandlerDisable = eventHandler;
-		return *this;
+		return getLaneVelocity( &TransformStore::mScale, VecType( 0.0f ) );
 	}
 
-	template<typename V, typename Y>
-	inline UiTreeT<T>& connectDisableEventHandler( V eventHandler, Y* eventHandlerObject )
+	inline float getScaleVelocityDecay() const
 	{
-		return connectDisableEventHandler( std::bind( eventHandler, eventHandlerObject, std::placeholders::_1 ) );
+		return getLaneVelocityDecay( &TransformStore::mScale );
 	}
 
-	inline UiTreeT<T>& disconnectDisableEventHandler()
+	/*
+	 * Returns this node's cached transform to world space, 
+	 * recomputing it if a local transform up the tree has 
+	 * changed. Children inherit translate, registration, 
+	 * rotation and group scale. Scale only applies to the node 
+	 * itself, as it usually sizes the node's shape. Group scale 
+	 * applies to the node and its whole subtree, so hit tests 
+	 * and bounds follow it too.
+	 */
+	inline const MatrixType& getWorldMatrix() const
 	{
-		mEventHandlerDisable = nullptr;
-		return *this;
+		validateWorldMatrix();
+		return mWorldMatrix;
 	}
 
-	inline UiTreeT<T>& connectEnableEventHandler( const std::function<void( UiTreeT<T>* )>& eventHandler )
+	/*
+	 * Returns a world space box around the shapes of this node 
+	 * and its descendants, covering every CollisionType. 
+	 * Subtrees tilted out of the x/y plane are unbounded. Needs 
+	 * UiTreeFeature_SpatialIndex.
+	 */
+	inline const ci::Rectf& getWorldBounds() const
 	{
-		mEventHandlerEnable = eventHandler;
-		return *this;
+		static_assert( hasFeature( UiTreeFeature_SpatialIndex ), "This tree type was built without node bounds" );
+		validateBounds();
+		return getSpatial()->mSubtreeBounds;
 	}
 
-	template<typename V, typename Y>
-	inline UiTreeT<T>& connectEnableEventHandler( V eventHandler, Y* eventHandlerObject )
+	inline VecType getTranslate() const
 	{
-		return connectEnableEventHandler( std::bind( eventHandler, eventHandlerObject, std::placeholders::_1 ) );
+		return getLaneValue( &TransformStore::mTranslate );
 	}
 
-	inline UiTreeT<T>& disconnectEnableEventHandler()
+	inline float getTranslateSpeed() const
 	{
-		mEventHandlerEnable = nullptr;
-		return *this;
+		return getLaneSpeed( &TransformStore::mTranslate );
 	}
 
-	inline UiTreeT<T>& connectHideEventHandler( const std::function<void( UiTreeT<T>* )>& eventHandler )
+	inline VecType getTranslateTarget() const
 	{
-		mEventHandlerHide = eventHandler;
-		return *this;
+		return getLaneTarget( &TransformStore::mTranslate );
 	}
 
-	template<typename V, typename Y>
-	inline UiTreeT<T>& connectHideEventHandler( V eventHandler, Y* eventHandlerObject )
+	inline VecType getTranslateVelocity() const
 	{
-		return connectHideEventHandler( std::bind( eventHandler, eventHandlerObject, std::placeholders::_1 ) );
+		return getLaneVelocity( &TransformStore::mTranslate, VecType( 0.0f ) );
 	}
 
-	inline UiTreeT<T>& disconnectHideEventHandler()
+	inline float getTranslateVelocityDecay() const
 	{
-		mEventHandlerHide = nullptr;
-		return *this;
+		return getLaneVelocityDecay( &TransformStore::mTranslate );
 	}
 
-	inline UiTreeT<T>& connectKeyDownEventHandler( const std::function<void( UiTreeT<T>*, ci::app::KeyEvent& )>& eventHandler )
+	// Returns this node's translate in world space, using its parent's cached transform.
+	inline VecType calcAbsoluteTranslate() const
 	{
-		mEventHandlerKeyDown = eventHandler;
-		return *this;
+		if ( mParent == nullptr ) {
+			return getTranslate();
+		}
+		mParent->validateWorldMatrix();
+		return VecType( Transform::transform( mParent->mFrameMatrix, Transform::toVec3( getTranslate() ) ) );
 	}
 
-	template<typename V, typename Y>
-	inline UiTreeT<T>& connectKeyDownEventHandler( V eventHandler, Y* eventHandlerObject )
+	/*
+	 * Recomputes stale world matrices for this node and its 
+	 * descendants in one top-down pass over the node arena. 
+	 * Call once per frame before drawing or hit testing.
+	 */
+	inline void calcWorldMatrices()
 	{
-		return connectKeyDownEventHandler( std::bind( eventHandler, eventHandlerObject, std::placeholders::_1, std::placeholders::_2 ) );
+		Registry& registry		= getArena();
+		const uint32_t end		= registry.mSlots[ mSlot ].mEnd;
+		for ( uint32_t i = mSlot; i < end; ++i ) {
+			registry.mSlots[ i ].mNode->validateWorldMatrix( registry.mTransforms );
+		}
 	}
 
-	inline UiTreeT<T>& disconnectKeyDownEventHandler()
+	// Calculates the total number of nodes in this tree and its children.
+	inline size_t calcNumNodes() const
 	{
-		mEventHandlerKeyDown = nullptr;
-		return *this;
+		return calcNumNodes( 0 );
 	}
 
-	inline UiTreeT<T>& connectKeyUpEventHandler( const std::function<void( UiTreeT<T>*, ci::app::KeyEvent& )>& eventHandler )
+	inline void setChildren( const std::map<uint64_t, UiTreeT<T, P, F>>& c )
 	{
-		mEventHandlerKeyUp = eventHandler;
-		return *this;
+		clearChildren();
+		addChildren( c );
 	}
 
-	template<typename V, typename Y>
-	inline UiTreeT<T>& connectKeyUpEventHandler( V eventHandler, Y* eventHandlerObject )
+	inline void setChildren( std::map<uint64_t, UiTreeT<T, P, F>>&& c )
 	{
-		return connectKeyUpEventHandler( std::bind( eventHandler, eventHandlerObject, std::placeholders::_1, std::placeholders::_2 ) );
+		clearChildren();
+		addChildren( std::move( c ) );
 	}
 
-	inline UiTreeT<T>& disconnectKeyUpEventHandler()
+	/*
+	 * Sends mouse drags straight to this node, without walking 
+	 * the tree, until the mouse button is released or the 
+	 * capture is released. Mouse up events are still broadcast, 
+	 * and the capture ends after its broadcast.
+	 */
+	inline void capturePointer()
 	{
-		mEventHandlerKeyUp = nullptr;
-		return *this;
+		RootInput* input = getRegistry().getInput();
+		if ( input != nullptr ) {
+			input->mPointerCaptureId = mId;
+		}
 	}
 
-	inline UiTreeT<T>& connectMouseDownEventHandler( const std::function<void( UiTreeT<T>*, ci::app::MouseEvent& )>& eventHandler )
+	// Sends moves of the touch "touchId" straight to this node until the touch ends or the capture is released.
+	inline void capturePointer( uint32_t touchId )
 	{
-		mEventHandlerMouseDown = eventHandler;
-		return *this;
+		RootInput* input = getRegistry().getInput();
+		if ( input != nullptr ) {
+			input->mTouchCaptureIds[ touchId ] = mId;
+		}
 	}
 
-	template<typename V, typename Y>
-	inline UiTreeT<T>& connectMouseDownEventHandler( V eventHandler, Y* eventHandlerObject )
+	/*
+	 * Dispatches the mouse and touch moves queued since the last 
+	 * flush. update() calls this on the root before animating.
+	 */
+	inline void flushInput()
 	{
-		return connectMouseDownEventHandler( std::bind( eventHandler, eventHandlerObject, std::placeholders::_1, std::placeholders::_2 ) );
+		RootInput* input = getRegistry().getInput();
+		if ( input == nullptr ) {
+			return;
+		}
+		UiTreeT<T, P, F>& root = getRoot();
+		if ( input->mMouseQueued ) {
+			ci::app::MouseEvent event	= input->mMouseQueue;
+			input->mMouseQueued			= false;
+			if ( input->mMouseQueuedDrag ) {
+				root.dragMouse( event );
+			} else {
+				root.moveMouse( event );
+			}
+		}
+		if ( !input->mTouchQueue.empty() ) {
+			std::vector<ci::app::TouchEvent::Touch> touches;
+			touches.swap( input->mTouchQueue );
+			ci::app::TouchEvent event( input->mTouchQueueWindow, touches );
+			root.moveTouches( event );
+		}
+		input->mMouseSamples.clear();
+		input->mTouchSamples.clear();
 	}
 
-	inline UiTreeT<T>& disconnectMouseDownEventHandler()
+	/*
+	 * Moves focus to the next focusable, enabled node in 
+	 * preorder, wrapping around within the focus scope. The 
+	 * scope is the focused node's nearest ancestor marked with 
+	 * setFocusScope(), or the root. With nothing focused, the 
+	 * search starts from the root. Returns false if no node can 
+	 * take focus.
+	 */
+	inline bool focusNext()
 	{
-		mEventHandlerMouseDown = nullptr;
-		return *this;
+		return moveFocus( true );
 	}
 
-	inline UiTreeT<T>& connectMouseDragEventHandler( const std::function<void( UiTreeT<T>*, ci::app::MouseEvent& )>& eventHandler )
+	// Moves focus like focusNext(), in reverse preorder.
+	inline bool focusPrevious()
 	{
-		mEventHandlerMouseDrag = eventHandler;
-		return *this;
+		return moveFocus( false );
 	}
 
-	template<typename V, typename Y>
-	inline UiTreeT<T>& connectMouseDragEventHandler( V eventHandler, Y* eventHandlerObject )
+	// Ends this node's mouse capture.
+	inline void releasePointer()
 	{
-		return connectMouseDragEventHandler( std::bind( eventHandler, eventHandlerObject, std::placeholders::_1, std::placeholders::_2 ) );
+		RootInput* input = getRegistry().getInput();
+		if ( input != nullptr && input->mPointerCaptureId == mId ) {
+			input->mPointerCaptureId = Id_None;
+		}
 	}
 
-	inline UiTreeT<T>& disconnectMouseDragEventHandler()
+	// Ends this node's capture of the touch "touchId".
+	inline void releasePointer( uint32_t touchId )
 	{
-		mEventHandlerMouseDrag = nullptr;
-		return *this;
+		RootInput* input = getRegistry().getInput();
+		if ( input == nullptr ) {
+			return;
+		}
+		auto iter = input->mTouchCaptureIds.find( touchId );
+		if ( iter != input->mTouchCaptureIds.end() && iter->second == mId ) {
+			input->mTouchCaptureIds.erase( iter );
+		}
 	}
 
-	inline UiTreeT<T>& connectMouseMoveEventHandler( const std::function<void( UiTreeT<T>*, ci::app::MouseEvent& )>& eventHandler )
+	inline void setCollisionType( CollisionType t )
 	{
-		mEventHandlerMouseMove = eventHandler;
-		return *this;
+		mState.mCollisionType = t;
 	}
 
-	template<typename V, typename Y>
-	inline UiTreeT<T>& connectMouseMoveEventHandler( V eventHandler, Y* eventHandlerObject )
+	inline void setData( const T& d )
 	{
-		return connectMouseMoveEventHandler( std::bind( eventHandler, eventHandlerObject, std::placeholders::_1, std::placeholders::_2 ) );
+		mState.mData = d;
+	}
+
+	/*
+	 * Makes update( double ) advance the tree in steps of 
+	 * "seconds". Pass zero to integrate each call's delta time 
+	 * directly. Applies to the whole tree.
+	 */
+	inline void setFixedTimestep( double seconds )
+	{
+		Registry& registry			= getRegistry();
+		registry.mAccumulator		= 0.0;
+		registry.mFixedTimestep		= std::max( seconds, 0.0 );
+	}
+
+	inline void setEnabled( bool enabled )
+	{
+		bool prev		= mState.mEnabled;
+		mState.mEnabled	= enabled;
+		if ( prev != mState.mEnabled ) {
+			if ( mState.mEnabled ) {
+				if ( mParent == nullptr ) {
+					connectSignals();
+				}
+				emit<EventType_Enable>();
+			} else {
+				if ( mParent == nullptr ) {
+					disconnectSignals();
+				}
+				emit<EventType_Disable>();
+			}
+		}
+	}
+
+	// Marks this node as a stop for focusNext() and focusPrevious().
+	inline void setFocusable( bool focusable )
+	{
+		Input* input = getInput();
+		if ( input != nullptr ) {
+			input->mFocusable = focusable;
+		}
+	}
+
+	/*
+	 * Gives this node keyboard focus in its tree, or clears 
+	 * focus if this node has it. The node losing focus receives 
+	 * a blur event before this node receives a focus event. 
+	 * While a node is focused, key events go to it and bubble 
+	 * up its ancestors until one is handled, instead of being 
+	 * broadcast through the tree. Removing the focused node 
+	 * from its tree clears focus.
+	 */
+	inline void setFocused( bool focused )
+	{
+		RootInput* input		= getRegistry().getInput();
+		UiTreeT<T, P, F>* prev	= getFocusedNode();
+		if ( input == nullptr || focused == ( prev == this ) ) {
+			return;
+		}
+		input->mFocusId = focused ? mId : (uint64_t)Id_None;
+		if ( prev != nullptr ) {
+			prev->emit<EventType_Blur>();
+		}
+		if ( focused ) {
+			emit<EventType_Focus>();
+		}
+	}
+
+	// Keeps focusNext() and focusPrevious() inside this subtree while it holds the focused node.
+	inline void setFocusScope( bool scope )
+	{
+		Input* input = getInput();
+		if ( input != nullptr ) {
+			input->mFocusScope = scope;
+		}
+	}
+
+	/*
+	 * Nodes created without an explicit ID are numbered from a
+	 * counter kept by the root. Enable recycling to hand out the
+	 * IDs of removed nodes before advancing the counter. Applies
+	 * to the whole tree.
+	 */
+	inline void setIdRecyclingEnabled( bool enabled )
+	{
+		Registry& registry		= getRegistry();
+		registry.mRecycleIds	= enabled;
+		if ( !enabled ) {
+			registry.mFreeIds.clear();
+		}
+	}
+
+	// Applies to the whole tree. Switching to InputMode_Immediate flushes queued events.
+	inline void setInputMode( InputMode mode )
+	{
+		RootInput* input = getRegistry().getInput();
+		if ( input == nullptr ) {
+			return;
+		}
+		if ( mode == InputMode_Immediate ) {
+			flushInput();
+		}
+		input->mInputMode = mode;
+	}
+
+	/*
+	 * Links this node to "uiTree", another node in the same tree, 
+	 * without moving it out of the child map that holds it. If 
+	 * "uiTree" is removed, this node is linked back to the node 
+	 * holding it. Throws ExcInvalidParent if the link would 
+	 * change this node's root. Use addChild() to move nodes 
+	 * between trees.
+	 */
+	inline void setParent( UiTreeT<T, P, F>* uiTree )
+	{
+		if ( uiTree == nullptr ? mParent != nullptr : &uiTree->getRoot() != &getRoot() ) {
+			throw ExcInvalidParent( mId );
+		}
+		if ( uiTree != nullptr ) {
+			getRegistry().mRelinked = true;
+		}
+		mParent = uiTree;
+		invalidateWorldMatrix();
+	}
+
+	// Applies to the whole tree. Needs UiTreeFeature_SpatialIndex.
+	inline void setSpatialIndex( SpatialIndex index )
+	{
+		static_assert( hasFeature( UiTreeFeature_SpatialIndex ), "This tree type was built without the spatial index" );
+		Registry& registry = getRegistry();
+		registry.setSpatialIndex( index, registry.mGrid.mCellSize );
+	}
+
+	// Sets the width and height of a SpatialIndex_Grid cell, in world units. Applies to the whole tree.
+	inline void setSpatialGridCellSize( float size )
+	{
+		static_assert( hasFeature( UiTreeFeature_SpatialIndex ), "This tree type was built without the spatial index" );
+		Registry& registry = getRegistry();
+		registry.setSpatialIndex( registry.mSpatialIndex, std::max( size, 1.0f ) );
+	}
+
+	// Applies to the whole tree.
+	inline void setUpdateMode( UpdateMode mode )
+	{
+		getRegistry().mUpdateMode = mode;
+	}
+
+	inline void setVisible( bool visible )
+	{
+		bool prev		= mState.mVisible;
+		mState.mVisible	= visible;
+		if ( prev != mState.mVisible ) {
+			if ( mState.mVisible ) {
+				emit<EventType_Show>();
+			} else {
+				emit<EventType_Hide>();
+			}
+		}
+	}
+
+	/*
+	 * Scales this node and its whole subtree about the node's 
+	 * origin, including the positions of its descendants. Unlike 
+	 * setScale(), which sizes only this node's own shape, group 
+	 * scale is part of the frame children inherit. Leaves z 
+	 * unscaled, so the frame stays invertible.
+	 */
+	inline void setGroupScale( const ci::vec2& v, float speed = 1.0f )
+	{
+		assignValue( &TransformStore::mGroupScale, Transform::getVec( ci::vec3( v, 1.0f ) ), speed );
+	}
+
+	inline void setGroupScale( const ci::vec3& v, float speed = 1.0f )
+	{
+		assignValue( &TransformStore::mGroupScale, Transform::getVec( v ), speed );
+	}
+
+	inline void setGroupScaleVelocity( const ci::vec2& v, float decay = 1.0f )
+	{
+		assignVelocity( &TransformStore::mGroupScale, Transform::getVec( v ), decay );
+	}
+
+	inline void setGroupScaleVelocity( const ci::vec3& v, float decay = 1.0f )
+	{
+		assignVelocity( &TransformStore::mGroupScale, Transform::getVec( v ), decay );
+	}
+
+	inline void setRegistration( const ci::vec2& v, float speed = 1.0f )
+	{
+		assignValue( &TransformStore::mRegistration, Transform::getVec( v ), speed );
+	}
+
+	inline void setRegistration( const ci::vec3& v, float speed = 1.0f )
+	{
+		assignValue( &TransformStore::mRegistration, Transform::getVec( v ), speed );
+	}
+
+	inline void setRegistrationVelocity( const ci::vec2& v, float decay = 1.0f )
+	{
+		assignVelocity( &TransformStore::mRegistration, Transform::getVec( v ), decay );
+	}
+
+	inline void setRegistrationVelocity( const ci::vec3& v, float decay = 1.0f )
+	{
+		assignVelocity( &TransformStore::mRegistration, Transform::getVec( v ), decay );
+	}
+
+	inline void setRotation( float z, float speed = 1.0f )
+	{
+		assignRotation( Transform::getRotation( z ), speed );
+	}
+
+	inline void setRotation( const ci::quat& q, float speed = 1.0f )
+	{
+		assignRotation( Transform::getRotation( q ), speed );
+	}
+
+	inline void setRotationVelocity( float z, float decay = 1.0f )
+	{
+		assignVelocity( &TransformStore::mRotation, Transform::getRotation( z ), decay );
+	}
+
+	inline void setRotationVelocity( const ci::quat& q, float decay = 1.0f )
+	{
+		assignVelocity( &TransformStore::mRotation, Transform::getRotation( q ), decay );
+	}
+
+	inline void setScale( const ci::vec2& v, float speed = 1.0f )
+	{
+		assignValue( &TransformStore::mScale, Transform::getVec( v ), speed );
+	}
+
+	inline void setScale( const ci::vec3& v, float speed = 1.0f )
+	{
+		assignValue( &TransformStore::mScale, Transform::getVec( v ), speed );
+	}
+
+	inline void setScaleVelocity( const ci::vec2& v, float decay = 1.0f )
+	{
+		assignVelocity( &TransformStore::mScale, Transform::getVec( v ), decay );
+	}
+
+	inline void setScaleVelocity( const ci::vec3& v, float decay = 1.0f )
+	{
+		assignVelocity( &TransformStore::mScale, Transform::getVec( v ), decay );
+	}
+
+	inline void setTranslate( const ci::vec2& v, float speed = 1.0f )
+	{
+		assignValue( &TransformStore::mTranslate, Transform::getVec( v ), speed );
+	}
+
+	inline void setTranslate( const ci::vec3& v, float speed = 1.0f )
+	{
+		assignValue( &TransformStore::mTranslate, Transform::getVec( v ), speed );
+	}
+
+	inline void setTranslateVelocity( const ci::vec2& v, float decay = 1.0f )
+	{
+		assignVelocity( &TransformStore::mTranslate, Transform::getVec( v ), decay );
+	}
+
+	inline void setTranslateVelocity( const ci::vec3& v, float decay = 1.0f )
+	{
+		assignVelocity( &TransformStore::mTranslate, Transform::getVec( v ), decay );
+	}
+
+	inline UiTreeT<T, P, F>& connectBlurEventHandler( const std::function<void( UiTreeT<T, P, F>* )>& eventHandler )
+	{
+		setEventHandler<EventType_Blur>( eventHandler );
+		return *this;
+	}
+
+	template<typename V, typename Y>
+	inline UiTreeT<T, P, F>& connectBlurEventHandler( V eventHandler, Y* eventHandlerObject )
+	{
+		return connectBlurEventHandler( std::bind( eventHandler, eventHandlerObject, std::placeholders::_1 ) );
 	}
 
-	inline UiTreeT<T>& disconnectMouseMoveEventHandler()
+	inline UiTreeT<T, P, F>& disconnectBlurEventHandler()
 	{
-		mEventHandlerMouseMove = nullptr;
+		removeEventHandlers( EventType_Blur );
 		return *this;
 	}
 
-	inline UiTreeT<T>& connectMouseOutEventHandler( const std::function<void( UiTreeT<T>* )>& eventHandler )
+	inline UiTreeT<T, P, F>& connectDisableEventHandler( const std::function<void( UiTreeT<T, P, F>* )>& eventHandler )
 	{
-		mEventHandlerMouseOut = eventHandler;
+		setEventHandler<EventType_Disable>( eventHandler );
 		return *this;
 	}
 
 	template<typename V, typename Y>
-	inline UiTreeT<T>& connectMouseOutEventHandler( V eventHandler, Y* eventHandlerObject )
+	inline UiTreeT<T, P, F>& connectDisableEventHandler( V eventHandler, Y* eventHandlerObject )
 	{
-		return connectMouseOutEventHandler( std::bind( eventHandler, eventHandlerObject, std::placeholders::_1 ) );
+		return connectDisableEventHandler( std::bind( eventHandler, eventHandlerObject, std::placeholders::_1 ) );
 	}
 
-	inline UiTreeT<T>& disconnectMouseOutEventHandler()
+	inline UiTreeT<T, P, F>& disconnectDisableEventHandler()
 	{
-		mEventHandlerMouseOut = nullptr;
+		removeEventHandlers( EventType_Disable );
 		return *this;
 	}
 
-	inline UiTreeT<T>& connectMouseOverEventHandler( const std::function<void( UiTreeT<T>* )>& eventHandler )
+	inline UiTreeT<T, P, F>& connectEnableEventHandler( const std::function<void( UiTreeT<T, P, F>* )>& eventHandler )
 	{
-		mEventHandlerMouseOver = eventHandler;
+		setEventHandler<EventType_Enable>( eventHandler );
 		return *this;
 	}
 
 	template<typename V, typename Y>
-	inline UiTreeT<T>& connectMouseOverEventHandler( V eventHandler, Y* eventHandlerObject )
+	inline UiTreeT<T, P, F>& connectEnableEventHandler( V eventHandler, Y* eventHandlerObject )
 	{
-		return connectMouseOverEventHandler( std::bind( eventHandler, eventHandlerObject, std::placeholders::_1 ) );
+		return connectEnableEventHandler( std::bind( eventHandler, eventHandlerObject, std::placeholders::_1 ) );
 	}
 
-	inline UiTreeT<T>& disconnectMouseOverEventHandler()
+	inline UiTreeT<T, P, F>& disconnectEnableEventHandler()
 	{
-		mEventHandlerMouseOver = nullptr;
+		removeEventHandlers( EventType_Enable );
 		return *this;
 	}
 
-	inline UiTreeT<T>& connectMouseUpEventHandler( const std::function<void( UiTreeT<T>*, ci::app::MouseEvent& )>& eventHandler )
+	inline UiTreeT<T, P, F>& connectFocusEventHandler( const std::function<void( UiTreeT<T, P, F>* )>& eventHandler )
 	{
-		mEventHandlerMouseUp = eventHandler;
+		setEventHandler<EventType_Focus>( eventHandler );
 		return *this;
 	}
 
 	template<typename V, typename Y>
-	inline UiTreeT<T>& connectMouseUpEventHandler( V eventHandler, Y* eventHandlerObject )
+	inline UiTreeT<T, P, F>& connectFocusEventHandler( V eventHandler, Y* eventHandlerObject )
 	{
-		return connectMouseUpEventHandler( std::bind( eventHandler, eventHandlerObject, std::placeholders::_1, std::placeholders::_2 ) );
+		return connectFocusEventHandler( std::bind( eventHandler, eventHandlerObject, std::placeholders::_1 ) );
 	}
 
-	inline UiTreeT<T>& disconnectMouseUpEventHandler()
+	inline UiTreeT<T, P, F>& disconnectFocusEventHandler()
 	{
-		mEventHandlerMouseUp = nullptr;
+		removeEventHandlers( EventType_Focus );
 		return *this;
 	}
 
-	inline UiTreeT<T>& connectMouseWheelEventHandler( const std::function<void( UiTreeT<T>*, ci::app::MouseEvent& )>& eventHandler )
+	inline UiTreeT<T, P, F>& connectHideEventHandler( const std::function<void( UiTreeT<T, P, F>* )>& eventHandler )
 	{
-		mEventHandlerMouseWheel = eventHandler;
+		setEventHandler<EventType_Hide>( eventHandler );
 		return *this;
 	}
 
 	template<typename V, typename Y>
-	inline UiTreeT<T>& connectMouseWheelEventHandler( V eventHandler, Y* eventHandlerObject )
+	inline UiTreeT<T, P, F>& connectHideEventHandler( V eventHandler, Y* eventHandlerObject )
 	{
-		return connectMouseWheelEventHandler( std::bind( eventHandler, eventHandlerObject, std::placeholders::_1, std::placeholders::_2 ) );
+		return connectHideEventHandler( std::bind( eventHandler, eventHandlerObject, std::placeholders::_1 ) );
 	}
 
-	inline UiTreeT<T>& disconnectMouseWheelEventHandler()
+	inline UiTreeT<T, P, F>& disconnectHideEventHandler()
 	{
-		mEventHandlerMouseWheel = nullptr;
+		removeEventHandlers( EventType_Hide );
 		return *this;
 	}
 
-	inline UiTreeT<T>& connectShowEventHandler( const std::function<void( UiTreeT<T>* )>& eventHandler )
+	inline UiTreeT<T, P, F>& connectKeyDownEventHandler( const std::function<void( UiTreeT<T, P, F>*, ci::app::KeyEvent& )>& eventHandler )
 	{
-		mEventHandlerShow = eventHandler;
+		setEventHandler<EventType_KeyDown>( eventHandler );
 		return *this;
 	}
 
 	template<typename V, typename Y>
-	inline UiTreeT<T>& connectShowEventHandler( V eventHandler, Y* eventHandlerObject )
+	inline UiTreeT<T, P, F>& connectKeyDownEventHandler( V eventHandler, Y* eventHandlerObject )
 	{
-		return connectShowEventHandler( std::bind( eventHandler, eventHandlerObject, std::placeholders::_1 ) );
+		return connectKeyDownEventHandler( std::bind( eventHandler, eventHandlerObject, std::placeholders::_1, std::placeholders::_2 ) );
 	}
 
-	inline UiTreeT<T>& disconnectShowEventHandler()
+	inline UiTreeT<T, P, F>& disconnectKeyDownEventHandler()
 	{
-		mEventHandlerShow = nullptr;
+		removeEventHandlers( EventType_KeyDown );
 		return *this;
 	}
-	
-	inline UiTreeT<T>& connectResizeEventHandler( const std::function<void( UiTreeT<T>* )>& eventHandler )
+
+	inline UiTreeT<T, P, F>& connectKeyUpEventHandler( const std::function<void( UiTreeT<T, P, F>*, ci::app::KeyEvent& )>& eventHandler )
 	{
-		mEventHandlerResize = eventHandler;
+		setEventHandler<EventType_KeyUp>( eventHandler );
 		return *this;
 	}
-	
+
 	template<typename V, typename Y>
-	inline UiTreeT<T>& connectResizeEventHandler( V eventHandler, Y* eventHandlerObject )
+	inline UiTreeT<T, P, F>& connectKeyUpEventHandler( V eventHandler, Y* eventHandlerObject )
 	{
-		return connectResizeEventHandler( std::bind( eventHandler, eventHandlerObject, std::placeholders::_1 ) );
+		return connectKeyUpEventHandler( std::bind( eventHandler, eventHandlerObject, std::placeholders::_1, std::placeholders::_2 ) );
 	}
-	
-	inline UiTreeT<T>& disconnectResizeEventHandler()
+
+	inline UiTreeT<T, P, F>& disconnectKeyUpEventHandler()
 	{
-		mEventHandlerResize = nullptr;
+		removeEventHandlers( EventType_KeyUp );
 		return *this;
 	}
 
-	inline UiTreeT<T>& connectTouchesBeganEventHandler( const std::function<void( UiTreeT<T>*, ci::app::TouchEvent& )>& eventHandler )
+	inline UiTreeT<T, P, F>& connectMouseDownEventHandler( const std::function<void( UiTreeT<T, P, F>*, ci::app::MouseEvent& )>& eventHandler )
 	{
-		mEventHandlerTouchesBegan = eventHandler;
+		setEventHandler<EventType_MouseDown>( eventHandler );
 		return *this;
 	}
 
 	template<typename V, typename Y>
-	inline UiTreeT<T>& connectTouchesBeganEventHandler( V eventHandler, Y* eventHandlerObject )
+	inline UiTreeT<T, P, F>& connectMouseDownEventHandler( V eventHandler, Y* eventHandlerObject )
 	{
-		return connectTouchesBeganEventHandler( std::bind( eventHandler, eventHandlerObject, std::placeholders::_1, std::placeholders::_2 ) );
+		return connectMouseDownEventHandler( std::bind( eventHandler, eventHandlerObject, std::placeholders::_1, std::placeholders::_2 ) );
 	}
 
-	inline UiTreeT<T>& disconnectTouchesBeganEventHandler()
+	inline UiTreeT<T, P, F>& disconnectMouseDownEventHandler()
 	{
-		mEventHandlerTouchesBegan = nullptr;
+		removeEventHandlers( EventType_MouseDown );
 		return *this;
 	}
 
-	inline UiTreeT<T>& connectTouchesEndedEventHandler( const std::function<void( UiTreeT<T>*, ci::app::TouchEvent& )>& eventHandler )
+	inline UiTreeT<T, P, F>& connectMouseDragEventHandler( const std::function<void( UiTreeT<T, P, F>*, ci::app::MouseEvent& )>& eventHandler )
 	{
-		mEventHandlerTouchesEnded = eventHandler;
+		setEventHandler<EventType_MouseDrag>( eventHandler );
 		return *this;
 	}
 
 	template<typename V, typename Y>
-	inline UiTreeT<T>& connectTouchesEndedEventHandler( V eventHandler, Y* eventHandlerObject )
+	inline UiTreeT<T, P, F>& connectMouseDragEventHandler( V eventHandler, Y* eventHandlerObject )
 	{
-		return connectTouchesEndedEventHandler( std::bind( eventHandler, eventHandlerObject, std::placeholders::_1, std::placeholders::_2 ) );
+		return connectMouseDragEventHandler( std::bind( eventHandler, eventHandlerObject, std::placeholders::_1, std::placeholders::_2 ) );
+	}
+
+	inline UiTreeT<T, P, F>& disconnectMouseDragEventHandler()
+	{
+		removeEventHandlers( EventType_MouseDrag );
+		return *this;
+	}
+
+	inline UiTreeT<T, P, F>& connectMouseMoveEventHandler( const std::function<void( UiTreeT<T, P, F>*, ci::app::MouseEvent& )>& eventHandler )
+	{
+		setEventHandler<EventType_MouseMove>( eventHandler );
+		return *this;
+	}
+
+	template<typename V, typename Y>
+	inline UiTreeT<T, P, F>& connectMouseMoveEventHandler( V eventHandler, Y* eventHandlerObject )
+	{
+		return connectMouseMoveEventHandler( std::bind( eventHandler, eventHandlerObject, std::placeholders::_1, std::placeholders::_2 ) );
+	}
+
+	inline UiTreeT<T, P, F>& disconnectMouseMoveEventHandler()
+	{
+		removeEventHandlers( EventType_MouseMove );
+		return *this;
+	}
+
+	inline UiTreeT<T, P, F>& connectMouseOutEventHandler( const std::function<void( UiTreeT<T, P, F>* )>& eventHandler )
+	{
+		setEventHandler<EventType_MouseOut>( eventHandler );
+		return *this;
+	}
+
+	template<typename V, typename Y>
+	inline UiTreeT<T, P, F>& connectMouseOutEventHandler( V eventHandler, Y* eventHandlerObject )
+	{
+		return connectMouseOutEventHandler( std::bind( eventHandler, eventHandlerObject, std::placeholders::_1 ) );
+	}
+
+	inline UiTreeT<T, P, F>& disconnectMouseOutEventHandler()
+	{
+		removeEventHandlers( EventType_MouseOut );
+		return *this;
+	}
+
+	inline UiTreeT<T, P, F>& connectMouseOverEventHandler( const std::function<void( UiTreeT<T, P, F>* )>& eventHandler )
+	{
+		setEventHandler<EventType_MouseOver>( eventHandler );
+		return *this;
+	}
+
+	template<typename V, typename Y>
+	inline UiTreeT<T, P, F>& connectMouseOverEventHandler( V eventHandler, Y* eventHandlerObject )
+	{
+		return connectMouseOverEventHandler( std::bind( eventHandler, eventHandlerObject, std::placeholders::_1 ) );
+	}
+
+	inline UiTreeT<T, P, F>& disconnectMouseOverEventHandler()
+	{
+		removeEventHandlers( EventType_MouseOver );
+		return *this;
+	}
+
+	inline UiTreeT<T, P, F>& connectMouseUpEventHandler( const std::function<void( UiTreeT<T, P, F>*, ci::app::MouseEvent& )>& eventHandler )
+	{
+		setEventHandler<EventType_MouseUp>( eventHandler );
+		return *this;
+	}
+
+	template<typename V, typename Y>
+	inline UiTreeT<T, P, F>& connectMouseUpEventHandler( V eventHandler, Y* eventHandlerObject )
+	{
+		return connectMouseUpEventHandler( std::bind( eventHandler, eventHandlerObject, std::placeholders::_1, std::placeholders::_2 ) );
+	}
+
+	inline UiTreeT<T, P, F>& disconnectMouseUpEventHandler()
+	{
+		removeEventHandlers( EventType_MouseUp );
+		return *this;
+	}
+
+	inline UiTreeT<T, P, F>& connectMouseWheelEventHandler( const std::function<void( UiTreeT<T, P, F>*, ci::app::MouseEvent& )>& eventHandler )
+	{
+		setEventHandler<EventType_MouseWheel>( eventHandler );
+		return *this;
+	}
+
+	template<typename V, typename Y>
+	inline UiTreeT<T, P, F>& connectMouseWheelEventHandler( V eventHandler, Y* eventHandlerObject )
+	{
+		return connectMouseWheelEventHandler( std::bind( eventHandler, eventHandlerObject, std::placeholders::_1, std::placeholders::_2 ) );
+	}
+
+	inline UiTreeT<T, P, F>& disconnectMouseWheelEventHandler()
+	{
+		removeEventHandlers( EventType_MouseWheel );
+		return *this;
+	}
+
+	inline UiTreeT<T, P, F>& connectShowEventHandler( const std::function<void( UiTreeT<T, P, F>* )>& eventHandler )
+	{
+		setEventHandler<EventType_Show>( eventHandler );
+		return *this;
+	}
+
+	template<typename V, typename Y>
+	inline UiTreeT<T, P, F>& connectShowEventHandler( V eventHandler, Y* eventHandlerObject )
+	{
+		return connectShowEventHandler( std::bind( eventHandler, eventHandlerObject, std::placeholders::_1 ) );
+	}
+
+	inline UiTreeT<T, P, F>& disconnectShowEventHandler()
+	{
+		removeEventHandlers( EventType_Show );
+		return *this;
+	}
+	
+	inline UiTreeT<T, P, F>& connectResizeEventHandler( const std::function<void( UiTreeT<T, P, F>* )>& eventHandler )
+	{
+		setEventHandler<EventType_Resize>( eventHandler );
+		return *this;
+	}
+	
+	template<typename V, typename Y>
+	inline UiTreeT<T, P, F>& connectResizeEventHandler( V eventHandler, Y* eventHandlerObject )
+	{
+		return connectResizeEventHandler( std::bind( eventHandler, eventHandlerObject, std::placeholders::_1 ) );
+	}
+	
+	inline UiTreeT<T, P, F>& disconnectResizeEventHandler()
+	{
+		removeEventHandlers( EventType_Resize );
+		return *this;
+	}
+
+	inline UiTreeT<T, P, F>& connectTouchesBeganEventHandler( const std::function<void( UiTreeT<T, P, F>*, ci::app::TouchEvent& )>& eventHandler )
+	{
+		setEventHandler<EventType_TouchesBegan>( eventHandler );
+		return *this;
+	}
+
+	template<typename V, typename Y>
+	inline UiTreeT<T, P, F>& connectTouchesBeganEventHandler( V eventHandler, Y* eventHandlerObject )
+	{
+		return connectTouchesBeganEventHandler( std::bind( eventHandler, eventHandlerObject, std::placeholders::_1, std::placeholders::_2 ) );
+	}
+
+	inline UiTreeT<T, P, F>& disconnectTouchesBeganEventHandler()
+	{
+		removeEventHandlers( EventType_TouchesBegan );
+		return *this;
+	}
+
+	inline UiTreeT<T, P, F>& connectTouchesEndedEventHandler( const std::function<void( UiTreeT<T, P, F>*, ci::app::TouchEvent& )>& eventHandler )
+	{
+		setEventHandler<EventType_TouchesEnded>( eventHandler );
+		return *this;
+	}
+
+	template<typename V, typename Y>
+	inline UiTreeT<T, P, F>& connectTouchesEndedEventHandler( V eventHandler, Y* eventHandlerObject )
+	{
+		return connectTouchesEndedEventHandler( std::bind( eventHandler, eventHandlerObject, std::placeholders::_1, std::placeholders::_2 ) );
+	}
+
+	inline UiTreeT<T, P, F>& disconnectTouchesEndedEventHandler()
+	{
+		removeEventHandlers( EventType_TouchesEnded );
+		return *this;
+	}
+
+	inline UiTreeT<T, P, F>& connectTouchesMovedEventHandler( const std::function<void( UiTreeT<T, P, F>*, ci::app::TouchEvent& )>& eventHandler )
+	{
+		setEventHandler<EventType_TouchesMoved>( eventHandler );
+		return *this;
+	}
+	
+	template<typename V, typename Y>
+	inline UiTreeT<T, P, F>& connectTouchesMovedEventHandler( V eventHandler, Y* eventHandlerObject )
+	{
+		return connectTouchesMovedEventHandler( std::bind( eventHandler, eventHandlerObject, std::placeholders::_1, std::placeholders::_2 ) );
+	}
+
+	inline UiTreeT<T, P, F>& disconnectTouchesMovedEventHandler()
+	{
+		removeEventHandlers( EventType_TouchesMoved );
+		return *this;
+	}
+
+	inline UiTreeT<T, P, F>& connectTouchOutEventHandler( const std::function<void( UiTreeT<T, P, F>*, uint32_t )>& eventHandler )
+	{
+		setEventHandler<EventType_TouchOut>( eventHandler );
+		return *this;
+	}
+	
+	template<typename V, typename Y>
+	inline UiTreeT<T, P, F>& connectTouchOutEventHandler( V eventHandler, Y* eventHandlerObject )
+	{
+		return connectTouchOutEventHandler( std::bind( eventHandler, eventHandlerObject, std::placeholders::_1, std::placeholders::_2 ) );
+	}
+
+	inline UiTreeT<T, P, F>& disconnectTouchOutEventHandler()
+	{
+		removeEventHandlers( EventType_TouchOut );
+		return *this;
+	}
+
+	inline UiTreeT<T, P, F>& connectTouchOverEventHandler( const std::function<void( UiTreeT<T, P, F>*, uint32_t )>& eventHandler )
+	{
+		setEventHandler<EventType_TouchOver>( eventHandler );
+		return *this;
+	}
+	
+	template<typename V, typename Y>
+	inline UiTreeT<T, P, F>& connectTouchOverEventHandler( V eventHandler, Y* eventHandlerObject )
+	{
+		return connectTouchOverEventHandler( std::bind( eventHandler, eventHandlerObject, std::placeholders::_1, std::placeholders::_2 ) );
+	}
+
+	inline UiTreeT<T, P, F>& disconnectTouchOverEventHandler()
+	{
+		removeEventHandlers( EventType_TouchOver );
+		return *this;
+	}
+
+	inline UiTreeT<T, P, F>& connectUpdateEventHandler( const std::function<void( UiTreeT<T, P, F>* )>& eventHandler )
+	{
+		setEventHandler<EventType_Update>( eventHandler );
+		return *this;
+	}
+	
+	template<typename V, typename Y>
+	inline UiTreeT<T, P, F>& connectUpdateEventHandler( V eventHandler, Y* eventHandlerObject )
+	{
+		return connectUpdateEventHandler( std::bind( eventHandler, eventHandlerObject, std::placeholders::_1 ) );
+	}
+
+	inline UiTreeT<T, P, F>& disconnectUpdateEventHandler()
+	{
+		removeEventHandlers( EventType_Update );
+		return *this;
+	}
+
+	/* USAGE
+	typedef UiTreeT<UiData> UiTree;
+	...
+	uint32_t id = node.addEventHandler<UiTree::EventType_MouseDown>( [ & ]( UiTree* node, MouseEvent& event )
+	{
+		...
+	} );
+	...
+	node.removeEventHandler( id );
+	*/
+	/*
+	 * Adds a handler for events of type "E" after the ones already 
+	 * connected to this node. The connect...EventHandler() methods 
+	 * only replace their own handler, so added ones stay in place. 
+	 * Returns an ID for removeEventHandler().
+	 */
+	template<EventType E>
+	inline uint32_t addEventHandler( const EventHandler<E>& eventHandler )
+	{
+		static_assert( ( getEventTypes() & ( 1u << E ) ) != 0, "This tree type was built without the input feature these events need" );
+		EventHandlers* handlers = eventHandler ? acquireEventHandlers() : nullptr;
+		if ( handlers == nullptr ) {
+			return 0;
+		}
+		uint32_t id = handlers->add( E, eventHandler );
+		invalidateRoutes();
+		if ( E == EventType_Update ) {
+			wake();
+		}
+		return id;
+	}
+
+	inline bool hasEventHandler( EventType type ) const
+	{
+		const EventHandlers* handlers = getEventHandlers();
+		return handlers != nullptr && ( handlers->mTypes & ( 1u << type ) ) != 0;
+	}
+
+	// Returns true if "feature" was compiled into this tree type.
+	static constexpr bool hasFeature( UiTreeFeature feature )
+	{
+		return ( F & feature ) != 0;
+	}
+
+	/*
+	 * One bit per event type nodes of this tree type receive. 
+	 * Lifecycle events are always sent. Input events need their 
+	 * feature, and focus and blur need at least one input.
+	 */
+	static constexpr uint32_t getEventTypes()
+	{
+		return ( 1u << EventType_Disable ) | ( 1u << EventType_Enable ) | ( 1u << EventType_Hide ) | 
+			( 1u << EventType_Resize ) | ( 1u << EventType_Show ) | ( 1u << EventType_Update ) | 
+			( hasFeature( UiTreeFeature_Input ) ? ( 1u << EventType_Blur ) | ( 1u << EventType_Focus ) : 0u ) | 
+			( hasFeature( UiTreeFeature_Keyboard ) ? ( 1u << EventType_KeyDown ) | ( 1u << EventType_KeyUp ) : 0u ) | 
+			( hasFeature( UiTreeFeature_Mouse ) ? ( 1u << EventType_MouseDown ) | ( 1u << EventType_MouseDrag ) | 
+				( 1u << EventType_MouseMove ) | ( 1u << EventType_MouseOut ) | ( 1u << EventType_MouseOver ) | 
+				( 1u << EventType_MouseUp ) | ( 1u << EventType_MouseWheel ) : 0u ) | 
+			( hasFeature( UiTreeFeature_Touch ) ? ( 1u << EventType_TouchesBegan ) | ( 1u << EventType_TouchesEnded ) | 
+				( 1u << EventType_TouchesMoved ) | ( 1u << EventType_TouchOut ) | ( 1u << EventType_TouchOver ) : 0u );
+	}
+
+	// Removes a handler added with addEventHandler(). Safe to call from inside a handler.
+	inline void removeEventHandler( uint32_t id )
+	{
+		EventHandlers* handlers = getEventHandlers();
+		if ( handlers != nullptr ) {
+			handlers->remove( id );
+			releaseEventHandlers();
+		}
+	}
+
+	/* USAGE
+	class Controls;
+	typedef UiTreeT<UiData, Controls> UiTree;
+
+	class Controls : public UiTree::EventPolicy
+	{
+	public:
+		void mouseDown( UiTree* node, MouseEvent& event );
+		void mouseUp( UiTree* node, MouseEvent& event );
+	};
+	...
+	node.connectEventPolicy( &mControls );
+	*/
+	/*
+	 * Connects an instance of the policy type "P" to this node. 
+	 * The events "P" redeclares from EventPolicy are passed to it 
+	 * with direct calls, before any handlers connected as 
+	 * functions. The rest are never routed to this node on its 
+	 * behalf. Pass nullptr to disconnect.
+	 */
+	inline UiTreeT<T, P, F>& connectEventPolicy( EventPolicyType* policy )
+	{
+		static_assert( ( EventHandlers::getPolicyTypes() & ~getEventTypes() ) == 0, "The policy handles events this tree type was built without" );
+		if ( policy == nullptr ) {
+			return disconnectEventPolicy();
+		}
+		acquireEventHandlers()->setPolicy( policy );
+		invalidateRoutes();
+		if ( hasEventHandler( EventType_Update ) ) {
+			wake();
+		}
+		return *this;
+	}
+
+	inline UiTreeT<T, P, F>& disconnectEventPolicy()
+	{
+		EventHandlers* handlers = getEventHandlers();
+		if ( handlers != nullptr ) {
+			handlers->setPolicy( nullptr );
+			releaseEventHandlers();
+		}
+		return *this;
+	}
+
+	inline EventPolicyType* getEventPolicy() const
+	{
+		const EventHandlers* handlers = getEventHandlers();
+		return handlers == nullptr ? nullptr : handlers->mPolicy;
+	}
+
+	// Disconnects every handler, including the event policy.
+	inline UiTreeT<T, P, F>& disconnectEventHandlers()
+	{
+		removeEventHandlers();
+		return *this;
+	}
+
+	/*
+	 * Animates this node and its descendants by one reference 
+	 * frame. Only nodes in the tree's active set are visited. A 
+	 * node falls asleep once an update leaves its animation state 
+	 * unchanged and is woken by the transform setters. Nodes with 
+	 * an update handler stay awake. Queued input is flushed 
+	 * first.
+	 */
+	inline void update()
+	{
+		flushInput();
+		advance( 1.0f );
+	}
+
+	/*
+	 * Animates this node and its descendants by "dt" seconds. 
+	 * Speeds and velocity decays are defined per reference frame 
+	 * of 1/60 s and are integrated exponentially, so motion does 
+	 * not depend on the frame rate. With a fixed timestep set, 
+	 * "dt" is accumulated and the tree advances in whole steps; 
+	 * call this once per frame on the root.
+	 */
+	inline void update( double dt )
+	{
+		static const double referenceRate	= 60.0;
+		static const size_t maxSteps		= 8;
+
+		flushInput();
+		if ( dt <= 0.0 ) {
+			return;
+		}
+		Registry& registry = getRegistry();
+		if ( registry.mFixedTimestep <= 0.0 ) {
+			advance( (float)( dt * referenceRate ) );
+			return;
+		}
+
+		// Steps beyond "maxSteps" are dropped so a slow frame 
+		// cannot schedule ever more work.
+		registry.mAccumulator += dt;
+		size_t count = 0;
+		while ( registry.mAccumulator >= registry.mFixedTimestep && count < maxSteps ) {
+			advance( (float)( registry.mFixedTimestep * referenceRate ) );
+			registry.mAccumulator -= registry.mFixedTimestep;
+			++count;
+		}
+		if ( count == maxSteps ) {
+			registry.mAccumulator = std::fmod( registry.mAccumulator, registry.mFixedTimestep );
+		}
+	}
+protected:
+	/*
+	 * Event types dispatched only into subtrees that hold a 
+	 * handler for them. Visibility and update events still 
+	 * visit every node.
+	 */
+	enum : uint16_t
+	{
+		Route_KeyDown		= 1 << 0, 
+		Route_KeyUp			= 1 << 1, 
+		Route_MouseDown		= 1 << 2, 
+		Route_MouseDrag		= 1 << 3, 
+		Route_MouseMove		= 1 << 4, 
+		Route_MouseUp		= 1 << 5, 
+		Route_MouseWheel	= 1 << 6, 
+		Route_Resize		= 1 << 7, 
+		Route_TouchesBegan	= 1 << 8, 
+		Route_TouchesEnded	= 1 << 9, 
+		Route_TouchesMoved	= 1 << 10
+	} typedef Route;
+
+	// Integrates active nodes in this subtree over "frames" reference frames.
+	inline void advance( float frames )
+	{
+		Registry& registry		= getArena();
+		TransformStore& store	= registry.mTransforms;
+		const uint32_t begin	= mSlot;
+		const uint32_t end		= registry.mSlots[ mSlot ].mEnd;
+
+		// Awake lanes of this subtree are moved to the front, so 
+		// the pass integrates one dense prefix of the store.
+		size_t count = store.mAwake;
+		if ( mParent != nullptr ) {
+			count = 0;
+			for ( uint32_t i = 0; i < store.mAwake; ++i ) {
+				const uint32_t slot = store.mNodes[ i ]->mSlot;
+				if ( slot >= begin && slot < end ) {
+					store.swap( i, (uint32_t)count++ );
+				}
+			}
+		}
+		store.integrate( registry.mUpdateMode, count, frames );
+
+		// Lanes are visited from the back, so putting one to sleep 
+		// only moves a lane that has already been visited, or one 
+		// outside this subtree, into its place. Each node visited 
+		// is marked at its post-order rank.
+		Grid* grid						= registry.mSpatialIndex == SpatialIndex_Grid ? &registry.mGrid : nullptr;
+		std::vector<uint8_t>& marks		= registry.mUpdateMarks;
+		uint32_t first					= (uint32_t)registry.mPostOrder.size();
+		uint32_t last					= 0;
+		marks.resize( registry.mPostOrder.size(), 0 );
+		for ( size_t i = count; i-- > 0; ) {
+			UiTreeT<T, P, F>* node	= store.mNodes[ i ];
+			const uint32_t rank		= registry.mSlots[ node->mSlot ].mPost;
+			marks[ rank ]			= 1;
+			first					= std::min( first, rank );
+			last					= std::max( last, rank );
+			if ( store.mMoved[ i ] != 0 ) {
+				node->invalidateWorldMatrix( grid );
+			} else if ( !node->hasEventHandler( EventType_Update ) ) {
+				store.sleep( (uint32_t)i );
+			}
+		}
+
+		// Handlers run in post-order so children update before 
+		// their parents, which is the order of the arena's 
+		// post-order index between the first and last marks. The 
+		// handle buffer is borrowed so an update() called from a 
+		// handler fills its own.
+		std::vector<Handle> handles;
+		handles.swap( registry.mUpdateHandles );
+		handles.clear();
+		for ( uint32_t i = first; i <= last && count > 0; ++i ) {
+			if ( marks[ i ] != 0 ) {
+				marks[ i ] = 0;
+				handles.push_back( registry.mPostOrder[ i ]->mHandle );
+			}
+		}
+
+		// A handler may remove nodes later in the pass, so each 
+		// one is resolved again before its event is emitted.
+		for ( Handle handle : handles ) {
+			UiTreeT<T, P, F>* node = registry.resolve( handle );
+			if ( node != nullptr ) {
+				node->emit<EventType_Update>();
+			}
+		}
+		handles.swap( registry.mUpdateHandles );
+	}
+
+	/*
+	 * A node's entry in the root's node arena. The arena lists 
+	 * every node depth-first in one contiguous array, so a 
+	 * subtree occupies the slots from its own up to "mEnd", its 
+	 * first child follows it and its next sibling starts at 
+	 * "mEnd". "mPost" is the slot's rank in the registry's 
+	 * post-order index. Nodes stay in their parent's std::map, 
+	 * since the references getChildren(), find() and the child 
+	 * factories return must survive later insertions. Slot 
+	 * positions shift as subtrees are spliced in and out, so 
+	 * only handles are handed out.
+	 */
+	class Slot
+	{
+	public:
+		Slot( UiTreeT<T, P, F>* node, uint32_t parent )
+		: mEnd( 0 ), mNode( node ), mParent( parent ), mPost( 0 )
+		{
+		}
+
+		uint32_t												mEnd;
+		UiTreeT<T, P, F>*										mNode;
+		uint32_t												mParent;
+		uint32_t												mPost;
+	};
+
+	// Dense per-component arrays for a 2D vector channel.
+	class Vec2Array
+	{
+	public:
+		typedef ci::vec2 Value;
+
+		inline ci::vec2 get( size_t i ) const
+		{
+			return ci::vec2( mX[ i ], mY[ i ] );
+		}
+
+		inline void resize( size_t count )
+		{
+			mX.resize( count );
+			mY.resize( count );
+		}
+
+		inline void set( size_t i, const ci::vec2& v )
+		{
+			mX[ i ] = v.x;
+			mY[ i ] = v.y;
+		}
+
+		inline void swap( size_t a, size_t b )
+		{
+			std::swap( mX[ a ], mX[ b ] );
+			std::swap( mY[ a ], mY[ b ] );
+		}
+
+		std::vector<float>										mX;
+		std::vector<float>										mY;
+	};
+
+	// Dense per-component arrays for a vector channel.
+	class Vec3Array
+	{
+	public:
+		typedef ci::vec3 Value;
+
+		inline ci::vec3 get( size_t i ) const
+		{
+			return ci::vec3( mX[ i ], mY[ i ], mZ[ i ] );
+		}
+
+		inline void resize( size_t count )
+		{
+			mX.resize( count );
+			mY.resize( count );
+			mZ.resize( count );
+		}
+
+		inline void set( size_t i, const ci::vec3& v )
+		{
+			mX[ i ] = v.x;
+			mY[ i ] = v.y;
+			mZ[ i ] = v.z;
+		}
+
+		inline void swap( size_t a, size_t b )
+		{
+			std::swap( mX[ a ], mX[ b ] );
+			std::swap( mY[ a ], mY[ b ] );
+			std::swap( mZ[ a ], mZ[ b ] );
+		}
+
+		std::vector<float>										mX;
+		std::vector<float>										mY;
+		std::vector<float>										mZ;
+	};
+
+	// Dense per-component arrays for a rotation channel.
+	class QuatArray
+	{
+	public:
+		typedef ci::quat Value;
+
+		inline ci::quat get( size_t i ) const
+		{
+			return ci::quat( mW[ i ], mX[ i ], mY[ i ], mZ[ i ] );
+		}
+
+		inline void resize( size_t count )
+		{
+			mW.resize( count );
+			mX.resize( count );
+			mY.resize( count );
+			mZ.resize( count );
+		}
+
+		inline void set( size_t i, const ci::quat& q )
+		{
+			mW[ i ] = q.w;
+			mX[ i ] = q.x;
+			mY[ i ] = q.y;
+			mZ[ i ] = q.z;
+		}
+
+		inline void swap( size_t a, size_t b )
+		{
+			std::swap( mW[ a ], mW[ b ] );
+			std::swap( mX[ a ], mX[ b ] );
+			std::swap( mY[ a ], mY[ b ] );
+			std::swap( mZ[ a ], mZ[ b ] );
+		}
+
+		std::vector<float>										mW;
+		std::vector<float>										mX;
+		std::vector<float>										mY;
+		std::vector<float>										mZ;
+	};
+
+	// Dense array for a 2D rotation channel, holding angles about z.
+	class FloatArray
+	{
+	public:
+		typedef float Value;
+
+		inline float get( size_t i ) const
+		{
+			return mZ[ i ];
+		}
+
+		inline void resize( size_t count )
+		{
+			mZ.resize( count );
+		}
+
+		inline void set( size_t i, float z )
+		{
+			mZ[ i ] = z;
+		}
+
+		inline void swap( size_t a, size_t b )
+		{
+			std::swap( mZ[ a ], mZ[ b ] );
+		}
+
+		std::vector<float>										mZ;
+	};
+
+	// The arrays matching this tree's transform types.
+	typedef typename std::conditional<( F & UiTreeFeature_Transform2D ) != 0, FloatArray, QuatArray>::type RotationArray;
+	typedef typename std::conditional<( F & UiTreeFeature_Transform2D ) != 0, Vec2Array, Vec3Array>::type VecArray;
+
+	/*
+	 * One animated channel: value, target, velocity, speed and 
+	 * decay, with a lane per node. Trees built without 
+	 * UiTreeFeature_Animation only store values.
+	 */
+	template<typename A>
+	class Channel
+	{
+	public:
+		// Copies lane "from" of "c" into lane "i".
+		inline void copy( size_t i, const Channel<A>& c, size_t from )
+		{
+			mValue.set( i, c.mValue.get( from ) );
+			if ( hasFeature( UiTreeFeature_Animation ) ) {
+				mTarget.set( i, c.mTarget.get( from ) );
+				mVelocity.set( i, c.mVelocity.get( from ) );
+				mSpeed[ i ]			= c.mSpeed[ from ];
+				mVelocityDecay[ i ]	= c.mVelocityDecay[ from ];
+			}
+		}
+
+		/*
+		 * Converts per-frame speed and decay of the first "count" 
+		 * lanes to their exact equivalents over "frames" frames, 
+		 * for a step spanning other than one reference frame.
+		 */
+		inline void prepare( size_t count, float frames )
+		{
+			static const float epsilon = 0.01f;
+
+			for ( size_t i = 0; i < count; ++i ) {
+				const auto velocity	= mVelocity.get( i );
+				const float speed	= mSpeed[ i ];
+				float d				= std::sqrt( glm::dot( velocity, velocity ) ) < epsilon ? 0.0f : mVelocityDecay[ i ];
+				mBlend[ i ]			= speed >= 1.0f ? 1.0f : speed <= 0.0f ? 0.0f : 1.0f - std::pow( 1.0f - speed, frames );
+				mStep[ i ]			= std::pow( d, frames );
+				mGain[ i ]			= d == 1.0f ? frames : ( 1.0f - mStep[ i ] ) / ( 1.0f - d );
+			}
+		}
+
+		// Puts lane "i" at rest on "value".
+		template<typename V>
+		inline void reset( size_t i, const V& value, const V& zero, float speed )
+		{
+			mValue.set( i, value );
+			if ( hasFeature( UiTreeFeature_Animation ) ) {
+				mTarget.set( i, value );
+				mVelocity.set( i, zero );
+				mSpeed[ i ]			= speed;
+				mVelocityDecay[ i ]	= 0.0f;
+			}
+		}
+
+		inline void resize( size_t count )
+		{
+			mValue.resize( count );
+			if ( hasFeature( UiTreeFeature_Animation ) ) {
+				mTarget.resize( count );
+				mVelocity.resize( count );
+				mBlend.resize( count );
+				mGain.resize( count );
+				mSpeed.resize( count );
+				mStep.resize( count );
+				mVelocityDecay.resize( count );
+			}
+		}
+
+		inline void swap( size_t a, size_t b )
+		{
+			mValue.swap( a, b );
+			if ( hasFeature( UiTreeFeature_Animation ) ) {
+				mTarget.swap( a, b );
+				mVelocity.swap( a, b );
+				std::swap( mSpeed[ a ], mSpeed[ b ] );
+				std::swap( mVelocityDecay[ a ], mVelocityDecay[ b ] );
+			}
+		}
+
+		A														mTarget;
+		A														mValue;
+		A														mVelocity;
+		std::vector<float>										mBlend;			// Lerp factor for the step
+		std::vector<float>										mGain;			// Velocity added to target, in frames
+		std::vector<float>										mSpeed;
+		std::vector<float>										mStep;			// Velocity decay over the step
+		std::vector<float>										mVelocityDecay;
+	};
+
+	/*
+	 * Structure-of-arrays transform state of every node in a 
+	 * tree, owned by the root. Each node holds a lane, which 
+	 * its getters and setters read and write in place. Awake 
+	 * nodes hold the lanes before "mAwake", so an update 
+	 * integrates one dense prefix of each channel in its own 
+	 * tight loop.
+	 */
+	class TransformStore
+	{
+	public:
+		TransformStore()
+		: mAwake( 0 )
+		{
+		}
+
+		// Appends a lane for "node" holding the identity transform.
+		inline uint32_t acquire( const UiTreeT<T, P, F>& node )
+		{
+			const uint32_t lane = (uint32_t)mNodes.size();
+			mNodes.push_back( const_cast<UiTreeT<T, P, F>*>( &node ) );
+			mGroupScale.resize( mNodes.size() );
+			mRegistration.resize( mNodes.size() );
+			mRotation.resize( mNodes.size() );
+			mScale.resize( mNodes.size() );
+			mTranslate.resize( mNodes.size() );
+			clear( lane );
+			node.mLane = lane;
+			return lane;
+		}
+
+		// Puts a lane at rest on the identity transform.
+		inline void clear( uint32_t lane )
+		{
+			mGroupScale.reset( lane, VecType( 1.0f ), VecType( 0.0f ), 1.0f );
+			mRegistration.reset( lane, VecType( 0.0f ), VecType( 0.0f ), 0.0f );
+			mRotation.reset( lane, RotationType(), Transform::getRotationZero(), 1.0f );
+			mScale.reset( lane, VecType( 1.0f ), VecType( 0.0f ), 1.0f );
+			mTranslate.reset( lane, VecType( 0.0f ), VecType( 0.0f ), 1.0f );
+		}
+
+		// Copies lane "from" of "store", which may be this store, into "lane".
+		inline void copy( uint32_t lane, const TransformStore& store, uint32_t from )
+		{
+			mGroupScale.copy( lane, store.mGroupScale, from );
+			mRegistration.copy( lane, store.mRegistration, from );
+			mRotation.copy( lane, store.mRotation, from );
+			mScale.copy( lane, store.mScale, from );
+			mTranslate.copy( lane, store.mTranslate, from );
+		}
+
+		// Integrates the first "count" lanes, flagging the ones that moved in "mMoved".
+		inline void integrate( UpdateMode mode, size_t count, float frames )
+		{
+			mMoved.assign( count, 0 );
+			if ( !hasFeature( UiTreeFeature_Animation ) ) {
+				return;
+			}
+			if ( frames != 1.0f ) {
+				mGroupScale.prepare( count, frames );
+				mRegistration.prepare( count, frames );
+				mRotation.prepare( count, frames );
+				mScale.prepare( count, frames );
+				mTranslate.prepare( count, frames );
+			}
+
+			uint8_t* moved		= mMoved.data();
+			size_t groupScale	= 0;
+			size_t registration	= 0;
+			size_t rotation		= 0;
+			size_t scale		= 0;
+			size_t translate	= 0;
+#if defined( UI_TREE_SSE2 )
+			if ( mode == UpdateMode_Simd ) {
+				groupScale		= integrateSse2( mGroupScale, count, moved, frames );
+				registration	= integrateSse2( mRegistration, count, moved, frames );
+				rotation		= integrateSse2( mRotation, count, moved, frames );
+				scale			= integrateSse2( mScale, count, moved, frames );
+				translate		= integrateSse2( mTranslate, count, moved, frames );
+			}
+#endif
+			integrate( mGroupScale, groupScale, count, moved, frames );
+			integrate( mRegistration, registration, count, moved, frames );
+			integrate( mRotation, rotation, count, moved, frames );
+			integrate( mScale, scale, count, moved, frames );
+			integrate( mTranslate, translate, count, moved, frames );
+		}
+
+		// Returns true if "node" holds a lane in this store.
+		inline bool owns( const UiTreeT<T, P, F>& node ) const
+		{
+			return node.mLane < mNodes.size() && mNodes[ node.mLane ] == &node;
+		}
+
+		// Frees a lane in constant time by moving the last lane into it.
+		inline void release( uint32_t lane )
+		{
+			if ( lane < mAwake ) {
+				swap( lane, --mAwake );
+				lane = mAwake;
+			}
+			swap( lane, (uint32_t)mNodes.size() - 1 );
+			mNodes.back()->mLane = Handle_None;
+			mNodes.pop_back();
+			mGroupScale.resize( mNodes.size() );
+			mRegistration.resize( mNodes.size() );
+			mRotation.resize( mNodes.size() );
+			mScale.resize( mNodes.size() );
+			mTranslate.resize( mNodes.size() );
+		}
+
+		// Moves an awake lane out of the awake prefix.
+		inline void sleep( uint32_t lane )
+		{
+			if ( lane < mAwake ) {
+				swap( lane, --mAwake );
+			}
+		}
+
+		// Exchanges two lanes, updating the nodes that hold them.
+		inline void swap( uint32_t a, uint32_t b )
+		{
+			if ( a != b ) {
+				mGroupScale.swap( a, b );
+				mRegistration.swap( a, b );
+				mRotation.swap( a, b );
+				mScale.swap( a, b );
+				mTranslate.swap( a, b );
+				std::swap( mNodes[ a ], mNodes[ b ] );
+				mNodes[ a ]->mLane = a;
+				mNodes[ b ]->mLane = b;
+			}
+		}
+
+		inline void wake( uint32_t lane )
+		{
+			if ( lane >= mAwake ) {
+				swap( lane, mAwake++ );
+			}
+		}
+
+		uint32_t												mAwake;
+		std::vector<uint8_t>									mMoved;			// Lanes changed by the last integration
+		std::vector<UiTreeT<T, P, F>*>							mNodes;			// The node holding each lane
+		Channel<VecArray>										mGroupScale;		// Inherited by descendants
+		Channel<VecArray>										mRegistration;
+		Channel<RotationArray>									mRotation;
+		Channel<VecArray>										mScale;
+		Channel<VecArray>										mTranslate;
+	protected:
+		// Applies velocity to target, then eases value toward target.
+		static inline void integrate( Channel<Vec3Array>& c, size_t begin, size_t count, uint8_t* moved, float frames )
+		{
+			static const float epsilon = 0.01f;
+
+			float* vx = c.mVelocity.mX.data();
+			float* vy = c.mVelocity.mY.data();
+			float* vz = c.mVelocity.mZ.data();
+			float* tx = c.mTarget.mX.data();
+			float* ty = c.mTarget.mY.data();
+			float* tz = c.mTarget.mZ.data();
+			float* x = c.mValue.mX.data();
+			float* y = c.mValue.mY.data();
+			float* z = c.mValue.mZ.data();
+			float* decay = c.mVelocityDecay.data();
+			const bool scaled		= frames != 1.0f;
+			const float* blend		= scaled ? c.mBlend.data() : c.mSpeed.data();
+			const float* gain		= c.mGain.data();
+			const float* step		= c.mStep.data();
+
+			for ( size_t i = begin; i < count; ++i ) {
+				float l = std::sqrt( vx[ i ] * vx[ i ] + vy[ i ] * vy[ i ] + vz[ i ] * vz[ i ] );
+				if ( l < epsilon ) {
+					decay[ i ] = 0.0f;
+				}
+				if ( l > 0.0f ) {
+					moved[ i ] = 1;
+					float g = scaled ? gain[ i ] : 1.0f;
+					float k = scaled ? step[ i ] : decay[ i ];
+					tx[ i ] += vx[ i ] * g;
+					ty[ i ] += vy[ i ] * g;
+					tz[ i ] += vz[ i ] * g;
+					vx[ i ] *= k;
+					vy[ i ] *= k;
+					vz[ i ] *= k;
+				}
+			}
+			for ( size_t i = begin; i < count; ++i ) {
+				const float px = x[ i ];
+				const float py = y[ i ];
+				const float pz = z[ i ];
+				x[ i ] += ( tx[ i ] - px ) * blend[ i ];
+				y[ i ] += ( ty[ i ] - py ) * blend[ i ];
+				z[ i ] += ( tz[ i ] - pz ) * blend[ i ];
+				moved[ i ] |= x[ i ] != px || y[ i ] != py || z[ i ] != pz;
+			}
+		}
+
+		static inline void integrate( Channel<Vec2Array>& c, size_t begin, size_t count, uint8_t* moved, float frames )
+		{
+			static const float epsilon = 0.01f;
+
+			float* vx = c.mVelocity.mX.data();
+			float* vy = c.mVelocity.mY.data();
+			float* tx = c.mTarget.mX.data();
+			float* ty = c.mTarget.mY.data();
+			float* x = c.mValue.mX.data();
+			float* y = c.mValue.mY.data();
+			float* decay = c.mVelocityDecay.data();
+			const bool scaled		= frames != 1.0f;
+			const float* blend		= scaled ? c.mBlend.data() : c.mSpeed.data();
+			const float* gain		= c.mGain.data();
+			const float* step		= c.mStep.data();
+
+			for ( size_t i = begin; i < count; ++i ) {
+				float l = std::sqrt( vx[ i ] * vx[ i ] + vy[ i ] * vy[ i ] );
+				if ( l < epsilon ) {
+					decay[ i ] = 0.0f;
+				}
+				if ( l > 0.0f ) {
+					moved[ i ] = 1;
+					float g = scaled ? gain[ i ] : 1.0f;
+					float k = scaled ? step[ i ] : decay[ i ];
+					tx[ i ] += vx[ i ] * g;
+					ty[ i ] += vy[ i ] * g;
+					vx[ i ] *= k;
+					vy[ i ] *= k;
+				}
+			}
+			for ( size_t i = begin; i < count; ++i ) {
+				const float px = x[ i ];
+				const float py = y[ i ];
+				x[ i ] += ( tx[ i ] - px ) * blend[ i ];
+				y[ i ] += ( ty[ i ] - py ) * blend[ i ];
+				moved[ i ] |= x[ i ] != px || y[ i ] != py;
+			}
+		}
+
+		// Angles ease along the difference wrapped into [-pi, pi], so they take the short way around.
+		static inline void integrate( Channel<FloatArray>& c, size_t begin, size_t count, uint8_t* moved, float frames )
+		{
+			static const float epsilon	= 0.01f;
+			static const float pi		= (float)M_PI;
+			static const float twoPi	= (float)M_PI * 2.0f;
+
+			float* vz = c.mVelocity.mZ.data();
+			float* tz = c.mTarget.mZ.data();
+			float* z = c.mValue.mZ.data();
+			float* decay = c.mVelocityDecay.data();
+			const bool scaled		= frames != 1.0f;
+			const float* blend		= scaled ? c.mBlend.data() : c.mSpeed.data();
+			const float* gain		= c.mGain.data();
+			const float* step		= c.mStep.data();
+
+			for ( size_t i = begin; i < count; ++i ) {
+				float l = std::abs( vz[ i ] );
+				if ( l < epsilon ) {
+					decay[ i ] = 0.0f;
+				}
+				if ( l > 0.0f ) {
+					moved[ i ] = 1;
+					float g = scaled ? gain[ i ] : 1.0f;
+					float k = scaled ? step[ i ] : decay[ i ];
+					tz[ i ] += vz[ i ] * g;
+					vz[ i ] *= k;
+				}
+			}
+			for ( size_t i = begin; i < count; ++i ) {
+				const float pz = z[ i ];
+				float d = tz[ i ] - pz;
+				d -= twoPi * std::floor( ( d + pi ) / twoPi );
+				z[ i ] += d * blend[ i ];
+				moved[ i ] |= z[ i ] != pz;
+			}
+		}
+
+		// Slerps lane "i" of a rotation channel toward its target, flagging it if it moved.
+		static inline void slerp( Channel<QuatArray>& c, size_t i, float blend, uint8_t* moved )
+		{
+			const ci::quat q = c.mValue.get( i );
+			const ci::quat r = glm::slerp( q, c.mTarget.get( i ), blend );
+			c.mValue.set( i, r );
+			moved[ i ] |= r != q;
+		}
+
+		// Rotation velocity is added component-wise, then the value is slerped.
+		static inline void integrate( Channel<QuatArray>& c, size_t begin, size_t count, uint8_t* moved, float frames )
+		{
+			static const float epsilon = 0.01f;
+
+			float* vw = c.mVelocity.mW.data();
+			float* vx = c.mVelocity.mX.data();
+			float* vy = c.mVelocity.mY.data();
+			float* vz = c.mVelocity.mZ.data();
+			float* tw = c.mTarget.mW.data();
+			float* tx = c.mTarget.mX.data();
+			float* ty = c.mTarget.mY.data();
+			float* tz = c.mTarget.mZ.data();
+			float* decay = c.mVelocityDecay.data();
+			const bool scaled		= frames != 1.0f;
+			const float* blend		= scaled ? c.mBlend.data() : c.mSpeed.data();
+			const float* gain		= c.mGain.data();
+			const float* step		= c.mStep.data();
+
+			for ( size_t i = begin; i < count; ++i ) {
+				float l = std::sqrt( vw[ i ] * vw[ i ] + vx[ i ] * vx[ i ] + vy[ i ] * vy[ i ] + vz[ i ] * vz[ i ] );
+				if ( l < epsilon ) {
+					decay[ i ] = 0.0f;
+				}
+				if ( l > 0.0f ) {
+					moved[ i ] = 1;
+					float g = scaled ? gain[ i ] : 1.0f;
+					float k = scaled ? step[ i ] : decay[ i ];
+					tw[ i ] += vw[ i ] * g;
+					tx[ i ] += vx[ i ] * g;
+					ty[ i ] += vy[ i ] * g;
+					tz[ i ] += vz[ i ] * g;
+					vw[ i ] *= k;
+					vx[ i ] *= k;
+					vy[ i ] *= k;
+					vz[ i ] *= k;
+				}
+			}
+			for ( size_t i = begin; i < count; ++i ) {
+				slerp( c, i, blend[ i ], moved );
+			}
+		}
+
+#if defined( UI_TREE_SSE2 )
+		static inline __m128 select( __m128 mask, __m128 a, __m128 b )
+		{
+			return _mm_or_ps( _mm_and_ps( mask, a ), _mm_andnot_ps( mask, b ) );
+		}
+
+		// Flags each of four lanes whose bit is set in "mask".
+		static inline void flag( uint8_t* moved, __m128 mask )
+		{
+			const int bits = _mm_movemask_ps( mask );
+			for ( int j = 0; j < 4; ++j ) {
+				moved[ j ] |= ( bits >> j ) & 1;
+			}
+		}
+
+		// Integrates lanes four at a time. Returns the number of lanes processed.
+		static inline size_t integrateSse2( Channel<Vec2Array>& c, size_t size, uint8_t* moved, float frames )
+		{
+			const size_t count		= size & ~(size_t)3;
+			const __m128 epsilon	= _mm_set1_ps( 0.01f );
+			const __m128 zero		= _mm_setzero_ps();
+			float* vx = c.mVelocity.mX.data();
+			float* vy = c.mVelocity.mY.data();
+			float* tx = c.mTarget.mX.data();
+			float* ty = c.mTarget.mY.data();
+			float* x = c.mValue.mX.data();
+			float* y = c.mValue.mY.data();
+			float* decay = c.mVelocityDecay.data();
+			const bool scaled		= frames != 1.0f;
+			const float* blend		= scaled ? c.mBlend.data() : c.mSpeed.data();
+			const float* gain		= c.mGain.data();
+			const float* step		= c.mStep.data();
+			const __m128 unit		= _mm_set1_ps( 1.0f );
+
+			for ( size_t i = 0; i < count; i += 4 ) {
+				__m128 vx4 = _mm_loadu_ps( vx + i );
+				__m128 vy4 = _mm_loadu_ps( vy + i );
+				__m128 l = _mm_sqrt_ps( _mm_add_ps( _mm_mul_ps( vx4, vx4 ), _mm_mul_ps( vy4, vy4 ) ) );
+				__m128 d = _mm_andnot_ps( _mm_cmplt_ps( l, epsilon ), _mm_loadu_ps( decay + i ) );
+				__m128 moving = _mm_cmpgt_ps( l, zero );
+				__m128 g = scaled ? _mm_loadu_ps( gain + i ) : unit;
+				__m128 k = scaled ? _mm_loadu_ps( step + i ) : d;
+				_mm_storeu_ps( decay + i, d );
+
+				__m128 tx4 = select( moving, _mm_add_ps( _mm_loadu_ps( tx + i ), _mm_mul_ps( vx4, g ) ), _mm_loadu_ps( tx + i ) );
+				__m128 ty4 = select( moving, _mm_add_ps( _mm_loadu_ps( ty + i ), _mm_mul_ps( vy4, g ) ), _mm_loadu_ps( ty + i ) );
+				_mm_storeu_ps( tx + i, tx4 );
+				_mm_storeu_ps( ty + i, ty4 );
+				_mm_storeu_ps( vx + i, select( moving, _mm_mul_ps( vx4, k ), vx4 ) );
+				_mm_storeu_ps( vy + i, select( moving, _mm_mul_ps( vy4, k ), vy4 ) );
+
+				__m128 s	= _mm_loadu_ps( blend + i );
+				__m128 x4	= _mm_loadu_ps( x + i );
+				__m128 y4	= _mm_loadu_ps( y + i );
+				__m128 nx4	= _mm_add_ps( x4, _mm_mul_ps( _mm_sub_ps( tx4, x4 ), s ) );
+				__m128 ny4	= _mm_add_ps( y4, _mm_mul_ps( _mm_sub_ps( ty4, y4 ), s ) );
+				_mm_storeu_ps( x + i, nx4 );
+				_mm_storeu_ps( y + i, ny4 );
+				flag( moved + i, _mm_or_ps( moving, _mm_or_ps( _mm_cmpneq_ps( nx4, x4 ), _mm_cmpneq_ps( ny4, y4 ) ) ) );
+			}
+			return count;
+		}
+
+		static inline size_t integrateSse2( Channel<Vec3Array>& c, size_t size, uint8_t* moved, float frames )
+		{
+			const size_t count		= size & ~(size_t)3;
+			const __m128 epsilon	= _mm_set1_ps( 0.01f );
+			const __m128 zero		= _mm_setzero_ps();
+			float* vx = c.mVelocity.mX.data();
+			float* vy = c.mVelocity.mY.data();
+			float* vz = c.mVelocity.mZ.data();
+			float* tx = c.mTarget.mX.data();
+			float* ty = c.mTarget.mY.data();
+			float* tz = c.mTarget.mZ.data();
+			float* x = c.mValue.mX.data();
+			float* y = c.mValue.mY.data();
+			float* z = c.mValue.mZ.data();
+			float* decay = c.mVelocityDecay.data();
+			const bool scaled		= frames != 1.0f;
+			const float* blend		= scaled ? c.mBlend.data() : c.mSpeed.data();
+			const float* gain		= c.mGain.data();
+			const float* step		= c.mStep.data();
+			const __m128 unit		= _mm_set1_ps( 1.0f );
+
+			for ( size_t i = 0; i < count; i += 4 ) {
+				__m128 vx4 = _mm_loadu_ps( vx + i );
+				__m128 vy4 = _mm_loadu_ps( vy + i );
+				__m128 vz4 = _mm_loadu_ps( vz + i );
+				__m128 l = _mm_sqrt_ps( _mm_add_ps( _mm_add_ps( _mm_mul_ps( vx4, vx4 ), _mm_mul_ps( vy4, vy4 ) ), _mm_mul_ps( vz4, vz4 ) ) );
+				__m128 d = _mm_andnot_ps( _mm_cmplt_ps( l, epsilon ), _mm_loadu_ps( decay + i ) );
+				__m128 moving = _mm_cmpgt_ps( l, zero );
+				__m128 g = scaled ? _mm_loadu_ps( gain + i ) : unit;
+				__m128 k = scaled ? _mm_loadu_ps( step + i ) : d;
+				_mm_storeu_ps( decay + i, d );
+
+				__m128 tx4 = select( moving, _mm_add_ps( _mm_loadu_ps( tx + i ), _mm_mul_ps( vx4, g ) ), _mm_loadu_ps( tx + i ) );
+				__m128 ty4 = select( moving, _mm_add_ps( _mm_loadu_ps( ty + i ), _mm_mul_ps( vy4, g ) ), _mm_loadu_ps( ty + i ) );
+				__m128 tz4 = select( moving, _mm_add_ps( _mm_loadu_ps( tz + i ), _mm_mul_ps( vz4, g ) ), _mm_loadu_ps( tz + i ) );
+				_mm_storeu_ps( tx + i, tx4 );
+				_mm_storeu_ps( ty + i, ty4 );
+				_mm_storeu_ps( tz + i, tz4 );
+				_mm_storeu_ps( vx + i, select( moving, _mm_mul_ps( vx4, k ), vx4 ) );
+				_mm_storeu_ps( vy + i, select( moving, _mm_mul_ps( vy4, k ), vy4 ) );
+				_mm_storeu_ps( vz + i, select( moving, _mm_mul_ps( vz4, k ), vz4 ) );
+
+				__m128 s	= _mm_loadu_ps( blend + i );
+				__m128 x4	= _mm_loadu_ps( x + i );
+				__m128 y4	= _mm_loadu_ps( y + i );
+				__m128 z4	= _mm_loadu_ps( z + i );
+				__m128 nx4	= _mm_add_ps( x4, _mm_mul_ps( _mm_sub_ps( tx4, x4 ), s ) );
+				__m128 ny4	= _mm_add_ps( y4, _mm_mul_ps( _mm_sub_ps( ty4, y4 ), s ) );
+				__m128 nz4	= _mm_add_ps( z4, _mm_mul_ps( _mm_sub_ps( tz4, z4 ), s ) );
+				_mm_storeu_ps( x + i, nx4 );
+				_mm_storeu_ps( y + i, ny4 );
+				_mm_storeu_ps( z + i, nz4 );
+				flag( moved + i, _mm_or_ps( _mm_or_ps( moving, _mm_cmpneq_ps( nx4, x4 ) ), 
+					_mm_or_ps( _mm_cmpneq_ps( ny4, y4 ), _mm_cmpneq_ps( nz4, z4 ) ) ) );
+			}
+			return count;
+		}
+
+		/*
+		 * Groups of four lanes whose rotations are all within 
+		 * epsilon of their targets take slerp's linear branch 
+		 * in SIMD. Other groups call glm::slerp per lane.
+		 */
+		static inline size_t integrateSse2( Channel<QuatArray>& c, size_t size, uint8_t* moved, float frames )
+		{
+			const size_t count		= size & ~(size_t)3;
+			const __m128 epsilon	= _mm_set1_ps( 0.01f );
+			const __m128 one		= _mm_set1_ps( 1.0f - std::numeric_limits<float>::epsilon() );
+			const __m128 sign		= _mm_set1_ps( -0.0f );
+			const __m128 zero		= _mm_setzero_ps();
+			float* vw = c.mVelocity.mW.data();
+			float* vx = c.mVelocity.mX.data();
+			float* vy = c.mVelocity.mY.data();
+			float* vz = c.mVelocity.mZ.data();
+			float* tw = c.mTarget.mW.data();
+			float* tx = c.mTarget.mX.data();
+			float* ty = c.mTarget.mY.data();
+			float* tz = c.mTarget.mZ.data();
+			float* w = c.mValue.mW.data();
+			float* x = c.mValue.mX.data();
+			float* y = c.mValue.mY.data();
+			float* z = c.mValue.mZ.data();
+			float* decay = c.mVelocityDecay.data();
+			const bool scaled		= frames != 1.0f;
+			const float* blend		= scaled ? c.mBlend.data() : c.mSpeed.data();
+			const float* gain		= c.mGain.data();
+			const float* step		= c.mStep.data();
+			const __m128 unit		= _mm_set1_ps( 1.0f );
+
+			for ( size_t i = 0; i < count; i += 4 ) {
+				__m128 vw4 = _mm_loadu_ps( vw + i );
+				__m128 vx4 = _mm_loadu_ps( vx + i );
+				__m128 vy4 = _mm_loadu_ps( vy + i );
+				__m128 vz4 = _mm_loadu_ps( vz + i );
+				__m128 l = _mm_sqrt_ps( _mm_add_ps( _mm_add_ps( _mm_add_ps( _mm_mul_ps( vw4, vw4 ), _mm_mul_ps( vx4, vx4 ) ), _mm_mul_ps( vy4, vy4 ) ), _mm_mul_ps( vz4, vz4 ) ) );
+				__m128 d = _mm_andnot_ps( _mm_cmplt_ps( l, epsilon ), _mm_loadu_ps( decay + i ) );
+				__m128 moving = _mm_cmpgt_ps( l, zero );
+				__m128 g = scaled ? _mm_loadu_ps( gain + i ) : unit;
+				__m128 k = scaled ? _mm_loadu_ps( step + i ) : d;
+				_mm_storeu_ps( decay + i, d );
+
+				__m128 tw4 = select( moving, _mm_add_ps( _mm_loadu_ps( tw + i ), _mm_mul_ps( vw4, g ) ), _mm_loadu_ps( tw + i ) );
+				__m128 tx4 = select( moving, _mm_add_ps( _mm_loadu_ps( tx + i ), _mm_mul_ps( vx4, g ) ), _mm_loadu_ps( tx + i ) );
+				__m128 ty4 = select( moving, _mm_add_ps( _mm_loadu_ps( ty + i ), _mm_mul_ps( vy4, g ) ), _mm_loadu_ps( ty + i ) );
+				__m128 tz4 = select( moving, _mm_add_ps( _mm_loadu_ps( tz + i ), _mm_mul_ps( vz4, g ) ), _mm_loadu_ps( tz + i ) );
+				_mm_storeu_ps( tw + i, tw4 );
+				_mm_storeu_ps( tx + i, tx4 );
+				_mm_storeu_ps( ty + i, ty4 );
+				_mm_storeu_ps( tz + i, tz4 );
+				_mm_storeu_ps( vw + i, select( moving, _mm_mul_ps( vw4, k ), vw4 ) );
+				_mm_storeu_ps( vx + i, select( moving, _mm_mul_ps( vx4, k ), vx4 ) );
+				_mm_storeu_ps( vy + i, select( moving, _mm_mul_ps( vy4, k ), vy4 ) );
+				_mm_storeu_ps( vz + i, select( moving, _mm_mul_ps( vz4, k ), vz4 ) );
+
+				__m128 w4 = _mm_loadu_ps( w + i );
+				__m128 x4 = _mm_loadu_ps( x + i );
+				__m128 y4 = _mm_loadu_ps( y + i );
+				__m128 z4 = _mm_loadu_ps( z + i );
+				__m128 cosTheta = _mm_add_ps( _mm_add_ps( _mm_add_ps( _mm_mul_ps( w4, tw4 ), _mm_mul_ps( x4, tx4 ) ), _mm_mul_ps( y4, ty4 ) ), _mm_mul_ps( z4, tz4 ) );
+				if ( _mm_movemask_ps( _mm_cmpgt_ps( _mm_andnot_ps( sign, cosTheta ), one ) ) != 0xf ) {
+					for ( size_t j = i; j < i + 4; ++j ) {
+						slerp( c, j, blend[ j ], moved );
+					}
+					flag( moved + i, moving );
+					continue;
+				}
+
+				// Take the short way around.
+				__m128 flip	= _mm_and_ps( _mm_cmplt_ps( cosTheta, zero ), sign );
+				__m128 s	= _mm_loadu_ps( blend + i );
+				tw4 = _mm_xor_ps( tw4, flip );
+				tx4 = _mm_xor_ps( tx4, flip );
+				ty4 = _mm_xor_ps( ty4, flip );
+				tz4 = _mm_xor_ps( tz4, flip );
+				__m128 nw4	= _mm_add_ps( w4, _mm_mul_ps( s, _mm_sub_ps( tw4, w4 ) ) );
+				__m128 nx4	= _mm_add_ps( x4, _mm_mul_ps( s, _mm_sub_ps( tx4, x4 ) ) );
+				__m128 ny4	= _mm_add_ps( y4, _mm_mul_ps( s, _mm_sub_ps( ty4, y4 ) ) );
+				__m128 nz4	= _mm_add_ps( z4, _mm_mul_ps( s, _mm_sub_ps( tz4, z4 ) ) );
+				_mm_storeu_ps( w + i, nw4 );
+				_mm_storeu_ps( x + i, nx4 );
+				_mm_storeu_ps( y + i, ny4 );
+				_mm_storeu_ps( z + i, nz4 );
+				flag( moved + i, _mm_or_ps( _mm_or_ps( _mm_or_ps( moving, _mm_cmpneq_ps( nw4, w4 ) ), _mm_cmpneq_ps( nx4, x4 ) ), 
+					_mm_or_ps( _mm_cmpneq_ps( ny4, y4 ), _mm_cmpneq_ps( nz4, z4 ) ) ) );
+			}
+			return count;
+		}
+
+		static inline size_t integrateSse2( Channel<FloatArray>& c, size_t size, uint8_t* moved, float frames )
+		{
+			const size_t count		= size & ~(size_t)3;
+			const __m128 epsilon	= _mm_set1_ps( 0.01f );
+			const __m128 pi			= _mm_set1_ps( (float)M_PI );
+			const __m128 sign		= _mm_set1_ps( -0.0f );
+			const __m128 turns		= _mm_set1_ps( 0.5f / (float)M_PI );
+			const __m128 twoPi		= _mm_set1_ps( (float)M_PI * 2.0f );
+			const __m128 zero		= _mm_setzero_ps();
+			float* vz = c.mVelocity.mZ.data();
+			float* tz = c.mTarget.mZ.data();
+			float* z = c.mValue.mZ.data();
+			float* decay = c.mVelocityDecay.data();
+			const bool scaled		= frames != 1.0f;
+			const float* blend		= scaled ? c.mBlend.data() : c.mSpeed.data();
+			const float* gain		= c.mGain.data();
+			const float* step		= c.mStep.data();
+			const __m128 unit		= _mm_set1_ps( 1.0f );
+
+			for ( size_t i = 0; i < count; i += 4 ) {
+				__m128 vz4 = _mm_loadu_ps( vz + i );
+				__m128 l = _mm_andnot_ps( sign, vz4 );
+				__m128 d = _mm_andnot_ps( _mm_cmplt_ps( l, epsilon ), _mm_loadu_ps( decay + i ) );
+				__m128 moving = _mm_cmpgt_ps( l, zero );
+				__m128 g = scaled ? _mm_loadu_ps( gain + i ) : unit;
+				__m128 k = scaled ? _mm_loadu_ps( step + i ) : d;
+				_mm_storeu_ps( decay + i, d );
+
+				__m128 tz4 = select( moving, _mm_add_ps( _mm_loadu_ps( tz + i ), _mm_mul_ps( vz4, g ) ), _mm_loadu_ps( tz + i ) );
+				_mm_storeu_ps( tz + i, tz4 );
+				_mm_storeu_ps( vz + i, select( moving, _mm_mul_ps( vz4, k ), vz4 ) );
+
+				// Wraps the difference into [-pi, pi]. SSE2 has no floor, 
+				// so truncation is corrected for negative values.
+				__m128 s	= _mm_loadu_ps( blend + i );
+				__m128 z4	= _mm_loadu_ps( z + i );
+				__m128 d4	= _mm_sub_ps( tz4, z4 );
+				__m128 n	= _mm_mul_ps( _mm_add_ps( d4, pi ), turns );
+				__m128 f	= _mm_cvtepi32_ps( _mm_cvttps_epi32( n ) );
+				f			= _mm_sub_ps( f, _mm_and_ps( _mm_cmpgt_ps( f, n ), unit ) );
+				d4			= _mm_sub_ps( d4, _mm_mul_ps( f, twoPi ) );
+				__m128 nz4	= _mm_add_ps( z4, _mm_mul_ps( d4, s ) );
+				_mm_storeu_ps( z + i, nz4 );
+				flag( moved + i, _mm_or_ps( moving, _mm_cmpneq_ps( nz4, z4 ) ) );
+			}
+			return count;
+		}
+#endif
+	};
+
+	/*
+	 * Points awaiting a hit in hitTest(), kept in dense x and y 
+	 * arrays so a rect can be tested against four at once. 
+	 * Points are swapped out of the batch as they resolve.
+	 */
+	class PointBatch
+	{
+	public:
+		inline void clear()
+		{
+			mIndex.clear();
+			mMask.clear();
+			mX.clear();
+			mY.clear();
+		}
+
+		// Flags the points inside "rect" in mMask. Returns how many were flagged.
+		inline size_t contains( const ci::Rectf& rect )
+		{
+			const size_t count	= mIndex.size();
+			size_t hits			= 0;
+			size_t i			= 0;
+#if defined( UI_TREE_SSE2 )
+			const __m128 x1 = _mm_set1_ps( rect.getX1() );
+			const __m128 y1 = _mm_set1_ps( rect.getY1() );
+			const __m128 x2 = _mm_set1_ps( rect.getX2() );
+			const __m128 y2 = _mm_set1_ps( rect.getY2() );
+			for ( ; i + 4 <= count; i += 4 ) {
+				const __m128 x	= _mm_loadu_ps( &mX[ i ] );
+				const __m128 y	= _mm_loadu_ps( &mY[ i ] );
+				const int mask	= _mm_movemask_ps( _mm_and_ps( 
+					_mm_and_ps( _mm_cmpge_ps( x, x1 ), _mm_cmple_ps( x, x2 ) ), 
+					_mm_and_ps( _mm_cmpge_ps( y, y1 ), _mm_cmple_ps( y, y2 ) ) ) );
+				for ( size_t j = 0; j < 4; ++j ) {
+					mMask[ i + j ]	= (uint8_t)( ( mask >> j ) & 1 );
+					hits			+= mMask[ i + j ];
+				}
+			}
+#endif
+			for ( ; i < count; ++i ) {
+				mMask[ i ]	= rect.contains( ci::vec2( mX[ i ], mY[ i ] ) ) ? 1 : 0;
+				hits		+= mMask[ i ];
+			}
+			return hits;
+		}
+
+		inline void erase( size_t i )
+		{
+			mIndex[ i ]	= mIndex.back();
+			mMask[ i ]	= mMask.back();
+			mX[ i ]		= mX.back();
+			mY[ i ]		= mY.back();
+			mIndex.pop_back();
+			mMask.pop_back();
+			mX.pop_back();
+			mY.pop_back();
+		}
+
+		inline void push_back( const ci::vec2& v, size_t index )
+		{
+			mIndex.push_back( index );
+			mMask.push_back( 0 );
+			mX.push_back( v.x );
+			mY.push_back( v.y );
+		}
+
+		std::vector<size_t>										mIndex;
+		std::vector<uint8_t>									mMask;
+		std::vector<float>										mX;
+		std::vector<float>										mY;
+	};
+
+	/*
+	 * Uniform grid over the x/y plane. Each node is listed in 
+	 * every cell its own bounds overlap. Nodes spanning too many 
+	 * cells, or unbounded, are kept in a list that every query 
+	 * visits. Nodes whose transforms change are queued by ID 
+	 * and re-inserted before the next query.
+	 */
+	class Grid
+	{
+	public:
+		Grid()
+		: mCellSize( 64.0f )
+		{
+		}
+
+		inline void clear()
+		{
+			mCells.clear();
+			mLarge.clear();
+			mQueue.clear();
+		}
+
+		inline void erase( UiTreeT<T, P, F>& node )
+		{
+			Spatial& spatial = *node.getSpatial();
+			if ( spatial.mGridLarge ) {
+				mLarge.erase( std::remove( mLarge.begin(), mLarge.end(), &node ), mLarge.end() );
+				spatial.mGridLarge = false;
+			}
+			for ( int32_t y = spatial.mCellMin.y; y <= spatial.mCellMax.y; ++y ) {
+				for ( int32_t x = spatial.mCellMin.x; x <= spatial.mCellMax.x; ++x ) {
+					auto iter = mCells.find( key( x, y ) );
+					if ( iter != mCells.end() ) {
+						std::vector<UiTreeT<T, P, F>*>& cell = iter->second;
+						cell.erase( std::remove( cell.begin(), cell.end(), &node ), cell.end() );
+						if ( cell.empty() ) {
+							mCells.erase( iter );
+						}
+					}
+				}
+			}
+			spatial.mCellMin = ci::ivec2( 1 );
+			spatial.mCellMax = ci::ivec2( 0 );
+		}
+
+		// Returns false if "rect" spans too many cells to list.
+		inline bool getCells( const ci::Rectf& rect, ci::ivec2& a, ci::ivec2& b ) const
+		{
+			static const double maxCells = 256.0;
+
+			const double x0 = std::floor( rect.getX1() / mCellSize );
+			const double y0 = std::floor( rect.getY1() / mCellSize );
+			const double x1 = std::floor( rect.getX2() / mCellSize );
+			const double y1 = std::floor( rect.getY2() / mCellSize );
+			if ( !( ( x1 - x0 + 1.0 ) * ( y1 - y0 + 1.0 ) <= maxCells ) ) {
+				return false;
+			}
+			a = ci::ivec2( (int32_t)x0, (int32_t)y0 );
+			b = ci::ivec2( (int32_t)x1, (int32_t)y1 );
+			return true;
+		}
+
+		// Lists "node" by its own bounds, which must be valid.
+		inline void insert( UiTreeT<T, P, F>& node )
+		{
+			Spatial& spatial = *node.getSpatial();
+			if ( !getCells( spatial.mBounds, spatial.mCellMin, spatial.mCellMax ) ) {
+				mLarge.push_back( &node );
+				spatial.mGridLarge = true;
+				return;
+			}
+			for ( int32_t y = spatial.mCellMin.y; y <= spatial.mCellMax.y; ++y ) {
+				for ( int32_t x = spatial.mCellMin.x; x <= spatial.mCellMax.x; ++x ) {
+					mCells[ key( x, y ) ].push_back( &node );
+				}
+			}
+		}
+
+		static inline uint64_t key( int32_t x, int32_t y )
+		{
+			return ( (uint64_t)(uint32_t)x << 32 ) | (uint64_t)(uint32_t)y;
+		}
+
+		// Forgets "node"'s place in a grid without touching any cells.
+		static inline void reset( UiTreeT<T, P, F>& node )
+		{
+			Spatial* spatial = node.getSpatial();
+			if ( spatial != nullptr ) {
+				spatial->mCellMin		= ci::ivec2( 1 );
+				spatial->mCellMax		= ci::ivec2( 0 );
+				spatial->mGridLarge		= false;
+				spatial->mGridQueued	= false;
+			}
+		}
+
+		inline void queue( UiTreeT<T, P, F>& node )
+		{
+			Spatial& spatial = *node.getSpatial();
+			if ( !spatial.mGridQueued ) {
+				spatial.mGridQueued = true;
+				mQueue.push_back( node.mId );
+			}
+		}
+
+		std::unordered_map<uint64_t, std::vector<UiTreeT<T, P, F>*>>	mCells;
+		float													mCellSize;
+		std::vector<UiTreeT<T, P, F>*>							mLarge;
+		std::vector<uint64_t>									mQueue;
+	};
+
+	/*
+	 * A node's event handlers, in the order they were added, in 
+	 * one contiguous list tagged by event type. Handlers removed 
+	 * while an event is being dispatched are only flagged, and 
+	 * handlers added meanwhile wait for the next event. Each 
+	 * event type has at most one connected handler, which the 
+	 * connect...EventHandler() methods replace.
+	 */
+	class EventHandlers
+	{
+	public:
+		class Listener
+		{
+		public:
+			Listener( uint32_t id, EventType type, bool connected, const std::function<void( UiTreeT<T, P, F>*, void* )>& function )
+			: mConnected( connected ), mFunction( function ), mId( id ), mRemoved( false ), mType( type )
+			{
+			}
+
+			bool												mConnected;
+			std::function<void( UiTreeT<T, P, F>*, void* )>		mFunction;	// Takes a pointer to the event, or touch ID, if any
+			uint32_t											mId;
+			bool												mRemoved;
+			EventType											mType;
+		};
+
+		EventHandlers()
+		: mDepth( 0 ), mNextId( 1 ), mPolicy( nullptr ), mRemoved( false ), mTypes( 0 )
+		{
+		}
+
+		EventHandlers( const EventHandlers& rhs )
+		: mAdded( rhs.mAdded ), mDepth( 0 ), mListeners( rhs.mListeners ), mNextId( rhs.mNextId ), 
+		mPolicy( rhs.mPolicy ), mRemoved( rhs.mRemoved ), mTypes( rhs.mTypes )
+		{
+			purge();
+		}
+
+		// Adds "f" after the handlers already in place. Returns its ID.
+		template<typename H>
+		inline uint32_t add( EventType type, const H& f )
+		{
+			return add( type, f, false );
+		}
+
+		// Replaces the handler connected for "type" with "f".
+		template<typename H>
+		inline uint32_t connect( EventType type, const H& f )
+		{
+			remove( 0, type, false );
+			return add( type, f, true );
+		}
+
+		// Calls the policy, then each listener, for events of type "E".
+		template<EventType E, typename... A>
+		inline void emit( UiTreeT<T, P, F>* node, A&... args )
+		{
+			if ( ( mTypes & ( 1u << E ) ) == 0 ) {
+				return;
+			}
+			++mDepth;
+			if ( mPolicy != nullptr && ( getPolicyTypes() & ( 1u << E ) ) != 0 ) {
+				call( *mPolicy, EventTag<E>(), node, args... );
+			}
+			emit( E, node, args... );
+			--mDepth;
+			purge();
+		}
+
+		inline bool empty() const
+		{
+			return mTypes == 0 && mDepth == 0 && mPolicy == nullptr;
+		}
+
+		inline void clear()
+		{
+			remove( 0, EventType_Blur, true );
+		}
+
+		inline void remove( uint32_t id )
+		{
+			remove( id, EventType_Blur, false );
+		}
+
+		// Removes the handler connected for "type".
+		inline void remove( EventType type )
+		{
+			remove( 0, type, false );
+		}
+
+		inline void setPolicy( EventPolicyType* policy )
+		{
+			mPolicy = policy;
+			calcTypes();
+		}
+
+		// One bit per event the policy type redeclares from EventPolicy.
+		static constexpr uint32_t getPolicyTypes()
+		{
+			return 
+				getPolicyType( &EventPolicyType::blur, &EventPolicy::blur, EventType_Blur ) | 
+				getPolicyType( &EventPolicyType::disable, &EventPolicy::disable, EventType_Disable ) | 
+				getPolicyType( &EventPolicyType::enable, &EventPolicy::enable, EventType_Enable ) | 
+				getPolicyType( &EventPolicyType::focus, &EventPolicy::focus, EventType_Focus ) | 
+				getPolicyType( &EventPolicyType::hide, &EventPolicy::hide, EventType_Hide ) | 
+				getPolicyType( &EventPolicyType::keyDown, &EventPolicy::keyDown, EventType_KeyDown ) | 
+				getPolicyType( &EventPolicyType::keyUp, &EventPolicy::keyUp, EventType_KeyUp ) | 
+				getPolicyType( &EventPolicyType::mouseDown, &EventPolicy::mouseDown, EventType_MouseDown ) | 
+				getPolicyType( &EventPolicyType::mouseDrag, &EventPolicy::mouseDrag, EventType_MouseDrag ) | 
+				getPolicyType( &EventPolicyType::mouseMove, &EventPolicy::mouseMove, EventType_MouseMove ) | 
+				getPolicyType( &EventPolicyType::mouseOut, &EventPolicy::mouseOut, EventType_MouseOut ) | 
+				getPolicyType( &EventPolicyType::mouseOver, &EventPolicy::mouseOver, EventType_MouseOver ) | 
+				getPolicyType( &EventPolicyType::mouseUp, &EventPolicy::mouseUp, EventType_MouseUp ) | 
+				getPolicyType( &EventPolicyType::mouseWheel, &EventPolicy::mouseWheel, EventType_MouseWheel ) | 
+				getPolicyType( &EventPolicyType::resize, &EventPolicy::resize, EventType_Resize ) | 
+				getPolicyType( &EventPolicyType::show, &EventPolicy::show, EventType_Show ) | 
+				getPolicyType( &EventPolicyType::touchesBegan, &EventPolicy::touchesBegan, EventType_TouchesBegan ) | 
+				getPolicyType( &EventPolicyType::touchesEnded, &EventPolicy::touchesEnded, EventType_TouchesEnded ) | 
+				getPolicyType( &EventPolicyType::touchesMoved, &EventPolicy::touchesMoved, EventType_TouchesMoved ) | 
+				getPolicyType( &EventPolicyType::touchOut, &EventPolicy::touchOut, EventType_TouchOut ) | 
+				getPolicyType( &EventPolicyType::touchOver, &EventPolicy::touchOver, EventType_TouchOver ) | 
+				getPolicyType( &EventPolicyType::update, &EventPolicy::update, EventType_Update );
+		}
+
+		std::vector<Listener>									mAdded;		// Added during dispatch, merged by purge()
+		uint32_t												mDepth;
+		std::vector<Listener>									mListeners;
+		uint32_t												mNextId;
+		EventPolicyType*										mPolicy;
+		bool													mRemoved;
+		uint32_t												mTypes;		// One bit per EventType with a handler
+	protected:
+		template<EventType E>
+		using EventTag = std::integral_constant<EventType, E>;
+
+		/*
+		 * Each signature is wrapped to take its argument through 
+		 * a pointer. The event type fixes the signature, so 
+		 * emit() casts back to the type the handler was added 
+		 * with.
+		 */
+		inline uint32_t add( EventType type, const std::function<void( UiTreeT<T, P, F>* )>& f, bool connected )
+		{
+			return push( type, connected, [ f ]( UiTreeT<T, P, F>* node, void* ) { f( node ); } );
+		}
+
+		inline uint32_t add( EventType type, const std::function<void( UiTreeT<T, P, F>*, ci::app::KeyEvent& )>& f, bool connected )
+		{
+			return push( type, connected, [ f ]( UiTreeT<T, P, F>* node, void* arg ) { f( node, *static_cast<ci::app::KeyEvent*>( arg ) ); } );
+		}
+
+		inline uint32_t add( EventType type, const std::function<void( UiTreeT<T, P, F>*, ci::app::MouseEvent& )>& f, bool connected )
+		{
+			return push( type, connected, [ f ]( UiTreeT<T, P, F>* node, void* arg ) { f( node, *static_cast<ci::app::MouseEvent*>( arg ) ); } );
+		}
+
+		inline uint32_t add( EventType type, const std::function<void( UiTreeT<T, P, F>*, ci::app::TouchEvent& )>& f, bool connected )
+		{
+			return push( type, connected, [ f ]( UiTreeT<T, P, F>* node, void* arg ) { f( node, *static_cast<ci::app::TouchEvent*>( arg ) ); } );
+		}
+
+		inline uint32_t add( EventType type, const std::function<void( UiTreeT<T, P, F>*, uint32_t )>& f, bool connected )
+		{
+			return push( type, connected, [ f ]( UiTreeT<T, P, F>* node, void* arg ) { f( node, *static_cast<uint32_t*>( arg ) ); } );
+		}
+
+		// Listeners added during dispatch are held back so the list never moves under a running handler.
+		inline uint32_t push( EventType type, bool connected, const std::function<void( UiTreeT<T, P, F>*, void* )>& f )
+		{
+			( mDepth > 0 ? mAdded : mListeners ).push_back( Listener( mNextId, type, connected, f ) );
+			mTypes |= 1u << type;
+			return mNextId++;
+		}
+
+		inline void emit( EventType type, UiTreeT<T, P, F>* node )
+		{
+			dispatch( type, node, nullptr );
+		}
+
+		inline void emit( EventType type, UiTreeT<T, P, F>* node, ci::app::KeyEvent& event )
+		{
+			dispatch( type, node, &event );
+		}
+
+		inline void emit( EventType type, UiTreeT<T, P, F>* node, ci::app::MouseEvent& event )
+		{
+			dispatch( type, node, &event );
+		}
+
+		inline void emit( EventType type, UiTreeT<T, P, F>* node, ci::app::TouchEvent& event )
+		{
+			dispatch( type, node, &event );
+		}
+
+		inline void emit( EventType type, UiTreeT<T, P, F>* node, uint32_t touchId )
+		{
+			dispatch( type, node, &touchId );
+		}
+
+		inline void dispatch( EventType type, UiTreeT<T, P, F>* node, void* arg )
+		{
+			const size_t count = mListeners.size();
+			for ( size_t i = 0; i < count; ++i ) {
+				Listener& listener = mListeners[ i ];
+				if ( listener.mType == type && !listener.mRemoved ) {
+					listener.mFunction( node, arg );
+				}
+			}
+		}
+
+		// Direct calls into the policy, one per event type.
+		static inline void call( EventPolicyType& policy, EventTag<EventType_Blur>, UiTreeT<T, P, F>* node )
+		{
+			policy.blur( node );
+		}
+
+		static inline void call( EventPolicyType& policy, EventTag<EventType_Disable>, UiTreeT<T, P, F>* node )
+		{
+			policy.disable( node );
+		}
+
+		static inline void call( EventPolicyType& policy, EventTag<EventType_Enable>, UiTreeT<T, P, F>* node )
+		{
+			policy.enable( node );
+		}
+
+		static inline void call( EventPolicyType& policy, EventTag<EventType_Focus>, UiTreeT<T, P, F>* node )
+		{
+			policy.focus( node );
+		}
+
+		static inline void call( EventPolicyType& policy, EventTag<EventType_Hide>, UiTreeT<T, P, F>* node )
+		{
+			policy.hide( node );
+		}
+
+		static inline void call( EventPolicyType& policy, EventTag<EventType_KeyDown>, UiTreeT<T, P, F>* node, ci::app::KeyEvent& event )
+		{
+			policy.keyDown( node, event );
+		}
+
+		static inline void call( EventPolicyType& policy, EventTag<EventType_KeyUp>, UiTreeT<T, P, F>* node, ci::app::KeyEvent& event )
+		{
+			policy.keyUp( node, event );
+		}
+
+		static inline void call( EventPolicyType& policy, EventTag<EventType_MouseDown>, UiTreeT<T, P, F>* node, ci::app::MouseEvent& event )
+		{
+			policy.mouseDown( node, event );
+		}
+
+		static inline void call( EventPolicyType& policy, EventTag<EventType_MouseDrag>, UiTreeT<T, P, F>* node, ci::app::MouseEvent& event )
+		{
+			policy.mouseDrag( node, event );
+		}
+
+		static inline void call( EventPolicyType& policy, EventTag<EventType_MouseMove>, UiTreeT<T, P, F>* node, ci::app::MouseEvent& event )
+		{
+			policy.mouseMove( node, event );
+		}
+
+		static inline void call( EventPolicyType& policy, EventTag<EventType_MouseOut>, UiTreeT<T, P, F>* node )
+		{
+			policy.mouseOut( node );
+		}
+
+		static inline void call( EventPolicyType& policy, EventTag<EventType_MouseOver>, UiTreeT<T, P, F>* node )
+		{
+			policy.mouseOver( node );
+		}
+
+		static inline void call( EventPolicyType& policy, EventTag<EventType_MouseUp>, UiTreeT<T, P, F>* node, ci::app::MouseEvent& event )
+		{
+			policy.mouseUp( node, event );
+		}
+
+		static inline void call( EventPolicyType& policy, EventTag<EventType_MouseWheel>, UiTreeT<T, P, F>* node, ci::app::MouseEvent& event )
+		{
+			policy.mouseWheel( node, event );
+		}
+
+		static inline void call( EventPolicyType& policy, EventTag<EventType_Resize>, UiTreeT<T, P, F>* node )
+		{
+			policy.resize( node );
+		}
+
+		static inline void call( EventPolicyType& policy, EventTag<EventType_Show>, UiTreeT<T, P, F>* node )
+		{
+			policy.show( node );
+		}
+
+		static inline void call( EventPolicyType& policy, EventTag<EventType_TouchesBegan>, UiTreeT<T, P, F>* node, ci::app::TouchEvent& event )
+		{
+			policy.touchesBegan( node, event );
+		}
+
+		static inline void call( EventPolicyType& policy, EventTag<EventType_TouchesEnded>, UiTreeT<T, P, F>* node, ci::app::TouchEvent& event )
+		{
+			policy.touchesEnded( node, event );
+		}
+
+		static inline void call( EventPolicyType& policy, EventTag<EventType_TouchesMoved>, UiTreeT<T, P, F>* node, ci::app::TouchEvent& event )
+		{
+			policy.touchesMoved( node, event );
+		}
+
+		static inline void call( EventPolicyType& policy, EventTag<EventType_TouchOut>, UiTreeT<T, P, F>* node, uint32_t touchId )
+		{
+			policy.touchOut( node, touchId );
+		}
+
+		static inline void call( EventPolicyType& policy, EventTag<EventType_TouchOver>, UiTreeT<T, P, F>* node, uint32_t touchId )
+		{
+			policy.touchOver( node, touchId );
+		}
+
+		static inline void call( EventPolicyType& policy, EventTag<EventType_Update>, UiTreeT<T, P, F>* node )
+		{
+			policy.update( node );
+		}
+
+
+		template<typename H, typename G>
+		static constexpr uint32_t getPolicyType( H, G, EventType type )
+		{
+			return std::is_same<H, G>::value ? 0 : 1u << type;
+		}
+
+		// Recomputes the type bits from the policy and the listeners left.
+		inline void calcTypes()
+		{
+			mTypes = mPolicy == nullptr ? 0 : getPolicyTypes();
+			calcTypes( mListeners );
+			calcTypes( mAdded );
+		}
+
+		inline void calcTypes( const std::vector<Listener>& listeners )
+		{
+			for ( const Listener& listener : listeners ) {
+				if ( !listener.mRemoved ) {
+					mTypes |= 1u << listener.mType;
+				}
+			}
+		}
+
+		// Drops flagged handlers, and merges added ones, once no event is being dispatched.
+		inline void purge()
+		{
+			if ( mDepth > 0 ) {
+				return;
+			}
+			if ( !mAdded.empty() ) {
+				for ( Listener& listener : mAdded ) {
+					mListeners.push_back( std::move( listener ) );
+				}
+				mAdded.clear();
+			}
+			if ( mRemoved ) {
+				mListeners.erase( std::remove_if( mListeners.begin(), mListeners.end(), 
+					[]( const Listener& listener ) { return listener.mRemoved; } ), mListeners.end() );
+				mRemoved = false;
+			}
+		}
+
+		/*
+		 * Flags the handler "id", or the handler connected for 
+		 * "type" when "id" is zero, or every handler and the 
+		 * policy.
+		 */
+		inline void remove( uint32_t id, EventType type, bool all )
+		{
+			if ( all ) {
+				mPolicy = nullptr;
+			}
+			remove( mListeners, id, type, all );
+			remove( mAdded, id, type, all );
+			calcTypes();
+			purge();
+		}
+
+		inline void remove( std::vector<Listener>& listeners, uint32_t id, EventType type, bool all )
+		{
+			for ( Listener& listener : listeners ) {
+				if ( !listener.mRemoved && ( all || ( id == 0 ? listener.mConnected && listener.mType == type : listener.mId == id ) ) ) {
+					listener.mRemoved	= true;
+					mRemoved			= true;
+				}
+			}
+		}
+	};
+
+	/*
+	 * A node's input state. Trees built without keyboard, mouse 
+	 * and touch replace it with an empty InputNone.
+	 */
+	class Input
+	{
+	public:
+		Input()
+		: mFocusable( false ), mFocusScope( false ), mMouseOver( false ), mRoutes( 0 )
+		{
+		}
+
+		bool													mFocusable;
+		bool													mFocusScope;
+		bool													mMouseOver;
+		uint16_t												mRoutes;
+	};
+
+	// Takes Input's place in a node when input is compiled out.
+	class InputNone
+	{
+	};
+
+	typedef typename std::conditional<( F & UiTreeFeature_Input ) != 0, Input, InputNone>::type InputType;
+
+	/*
+	 * A node's hit test caches: its world bounds, the grid cells 
+	 * it is listed in and the inverse of its frame matrix. Trees 
+	 * built without UiTreeFeature_SpatialIndex replace it with 
+	 * an empty SpatialNone.
+	 */
+	class Spatial
+	{
+	public:
+		Spatial()
+		: mBoundsDirty( true ), mCellMax( 0 ), mCellMin( 1 ), mGridLarge( false ), mGridQueued( false ), 
+		mInverseDirty( true ), mInverseFrameMatrix( 1.0f )
+		{
+		}
+
+		ci::Rectf												mBounds;
+		bool													mBoundsDirty;
+		ci::ivec2												mCellMax;
+		ci::ivec2												mCellMin;
+		bool													mGridLarge;
+		bool													mGridQueued;
+		bool													mInverseDirty;
+		MatrixType												mInverseFrameMatrix;
+		ci::Rectf												mSubtreeBounds;
+	};
+
+	// Takes Spatial's place in a node when the spatial index is compiled out.
+	class SpatialNone
+	{
+	};
+
+	typedef typename std::conditional<( F & UiTreeFeature_SpatialIndex ) != 0, Spatial, SpatialNone>::type SpatialType;
+
+	/*
+	 * The per-node state that copies and moves carry over as 
+	 * is. copyFrom() and moveFrom() assign it in one step, then 
+	 * fix up whatever a copy must not share with its source.
+	 */
+	class State
+	{
+	public:
+		State()
+		: mCollisionType( CollisionType_Rect ), mEnabled( false ), mVisible( false )
+		{
+		}
+
+		CollisionType											mCollisionType;
+		T														mData;
+		bool													mEnabled;
+		InputType												mInput;
+		bool													mVisible;
+	};
+
+	/*
+	 * A touch in progress and the IDs of the nodes under it, 
+	 * from the root down to the deepest node hit.
+	 */
+	class TouchPath
+	{
+	public:
+		TouchPath( const ci::app::TouchEvent::Touch& touch )
+		: mTouch( touch )
+		{
+		}
+
+		std::vector<uint64_t>									mPath;
+		ci::app::TouchEvent::Touch								mTouch;
+	};
+
+	/*
+	 * The input state a root keeps for its whole tree: focus, 
+	 * pointer captures, the hover and touch paths, and moves 
+	 * queued for the next flush. Trees built without keyboard, 
+	 * mouse and touch replace it with an empty RootInputNone.
+	 */
+	class RootInput
+	{
+	public:
+		RootInput()
+		: mFocusId( Id_None ), mInputMode( InputMode_Immediate ), mMouseQueued( false ), 
+		mMouseQueuedDrag( false ), mPointerCaptureId( Id_None )
+		{
+		}
+
+		// Drops every reference to the node "id", which is leaving the tree.
+		inline void erase( uint64_t id )
+		{
+			if ( mFocusId == id ) {
+				mFocusId = Id_None;
+			}
+			if ( mPointerCaptureId == id ) {
+				mPointerCaptureId = Id_None;
+			}
+			mNodeTouches.erase( id );
+			for ( auto iter = mTouchCaptureIds.begin(); iter != mTouchCaptureIds.end(); ) {
+				if ( iter->second == id ) {
+					iter = mTouchCaptureIds.erase( iter );
+				} else {
+					++iter;
+				}
+			}
+
+			// A removed node takes its descendants with it, so the path ends above it.
+			for ( auto& iter : mTouchPaths ) {
+				std::vector<uint64_t>& path = iter.second.mPath;
+				path.erase( std::find( path.begin(), path.end(), id ), path.end() );
+			}
+		}
+
+		// Refills each node's touch list from the touch paths, reusing the lists' buffers.
+		inline void collectTouches()
+		{
+			for ( auto& iter : mNodeTouches ) {
+				iter.second.clear();
+			}
+			for ( const auto& iter : mTouchPaths ) {
+				for ( uint64_t id : iter.second.mPath ) {
+					mNodeTouches[ id ].push_back( iter.second.mTouch );
+				}
+			}
+		}
+
+		uint64_t												mFocusId;
+		std::vector<uint64_t>									mHoverPath;
+		std::vector<uint64_t>									mHoverScratch;	// Buffer of the last path hover() replaced
+		InputMode												mInputMode;
+		ci::app::MouseEvent										mMouseQueue;
+		bool													mMouseQueued;
+		bool													mMouseQueuedDrag;
+		std::vector<ci::vec2>									mMouseSamples;
+		std::unordered_map<uint64_t, std::vector<ci::app::TouchEvent::Touch>>	mNodeTouches;	// Returned by getTouches()
+		uint64_t												mPointerCaptureId;
+		std::unordered_map<uint32_t, uint64_t>					mTouchCaptureIds;
+		std::vector<ci::app::TouchEvent::Touch>					mTouchQueue;
+		ci::app::WindowRef										mTouchQueueWindow;
+		std::unordered_map<uint32_t, TouchPath>					mTouchPaths;
+		std::unordered_map<uint32_t, std::vector<ci::vec2>>		mTouchSamples;
+		std::vector<uint64_t>									mTouchScratch;	// Buffer of the last path trackTouches() replaced
+	};
+
+	// Takes RootInput's place in a registry when input is compiled out.
+	class RootInputNone
+	{
+	};
+
+	typedef typename std::conditional<( F & UiTreeFeature_Input ) != 0, RootInput, RootInputNone>::type RootInputType;
+
+	/*
+	 * Lookup tables owned by the root of a tree. Child nodes
+	 * never use their own registry. The registry is built
+	 * on first use and kept in sync as nodes are added and
+	 * removed through the UiTreeT API.
+	 */
+	class Registry
+	{
+	public:
+		Registry( TransformStore& transforms )
+		: mAccumulator( 0.0 ), mArenaValid( false ), mBatchDepth( 0 ), mFixedTimestep( 0.0 ), 
+		mNextId( 0 ), mRecycleIds( false ), mRelinked( false ), mSpatialIndex( SpatialIndex_None ), 
+		mTransforms( transforms ), mUpdateMode( UpdateMode_Scalar )
+		{
+		}
+
+		~Registry()
+		{
+			disconnectSignals();
+		}
+
+		// Returns an unused ID in constant time.
+		inline uint64_t acquireId()
+		{
+			while ( mBatchDepth == 0 && !mFreeIds.empty() ) {
+				uint64_t id = mFreeIds.back();
+				mFreeIds.pop_back();
+				if ( mNodes.find( id ) == mNodes.end() ) {
+					return id;
+				}
+			}
+			return mNextId++;
+		}
+
+		inline void erase( UiTreeT<T, P, F>& node )
+		{
+			if ( mNodes.erase( node.mId ) > 0 && mRecycleIds ) {
+				mFreeIds.push_back( node.mId );
+			}
+			RootInput* input = getInput();
+			if ( input != nullptr ) {
+				input->erase( node.mId );
+			}
+			releaseHandle( node );
+			sleep( node );
+			if ( mSpatialIndex == SpatialIndex_Grid ) {
+				mGrid.erase( node );
+			}
+		}
+
+		inline void insert( UiTreeT<T, P, F>& node )
+		{
+			mNodes[ node.mId ]	= &node;
+			mNextId				= std::max<uint64_t>( mNextId, node.mId + 1 );
+			acquireHandle( node );
+			node.invalidateBounds();
+			wake( node );
+
+			// A node may still be listed in cells it has since moved out of.
+			if ( mSpatialIndex == SpatialIndex_Grid ) {
+				mGrid.erase( node );
+			}
+			Grid::reset( node );
+			if ( mSpatialIndex == SpatialIndex_Grid ) {
+				mGrid.queue( node );
+			}
+			node.propagateRoutes();
+		}
+
+		// Gives "node" an entry in the handle table, unless it already holds one.
+		inline void acquireHandle( UiTreeT<T, P, F>& node )
+		{
+			if ( resolve( node.mHandle ) == &node ) {
+				return;
+			}
+			uint32_t index = (uint32_t)mHandleNodes.size();
+			if ( mFreeHandles.empty() ) {
+				mHandleGenerations.push_back( 1 );
+				mHandleNodes.push_back( &node );
+			} else {
+				index					= mFreeHandles.back();
+				mHandleNodes[ index ]	= &node;
+				mFreeHandles.pop_back();
+			}
+			node.mHandle = ( (Handle)mHandleGenerations[ index ] << 32 ) | index;
+		}
+
+		// Frees the node's entry, advancing its generation so handles to it go stale.
+		inline void releaseHandle( UiTreeT<T, P, F>& node )
+		{
+			if ( resolve( node.mHandle ) == &node ) {
+				const uint32_t index		= (uint32_t)node.mHandle;
+				mHandleNodes[ index ]		= nullptr;
+				mHandleGenerations[ index ]	= std::max<uint32_t>( mHandleGenerations[ index ] + 1, 1 );
+				mFreeHandles.push_back( index );
+			}
+			node.mHandle = Handle_None;
+		}
+
+		// Returns the node "handle" refers to, or nullptr if the handle is stale.
+		inline UiTreeT<T, P, F>* resolve( Handle handle ) const
+		{
+			const uint32_t index = (uint32_t)handle;
+			if ( index >= mHandleNodes.size() || mHandleGenerations[ index ] != (uint32_t)( handle >> 32 ) ) {
+				return nullptr;
+			}
+			return mHandleNodes[ index ];
+		}
+
+		/*
+		 * Splices the slots of "child", which "owner" has just 
+		 * taken into its map, into the arena after the subtree 
+		 * of its preceding sibling. Only "child"'s subtree is 
+		 * walked. The slots after it and the ends of its 
+		 * ancestors are renumbered in one pass over the array. 
+		 * A stale arena is left for its next use to rebuild.
+		 */
+		inline void insertSlots( const UiTreeT<T, P, F>& owner, UiTreeT<T, P, F>& child )
+		{
+			if ( !mArenaValid ) {
+				return;
+			}
+			auto iter			= owner.mChildren.find( child.mId );
+			const uint32_t pos	= iter == owner.mChildren.begin() ? owner.mSlot + 1 : mSlots[ std::prev( iter )->second.mSlot ].mEnd;
+			mSlotScratch.clear();
+			child.buildArena( mSlotScratch, pos, owner.mSlot );
+			spliceSlots( pos, owner.mSlot, mSlotScratch.begin(), mSlotScratch.end() );
+		}
+
+		// Splices the slots of the children of "node", which keeps its own slot, into the arena.
+		inline void insertChildSlots( UiTreeT<T, P, F>& node )
+		{
+			if ( !mArenaValid ) {
+				return;
+			}
+			mSlotScratch.clear();
+			node.buildArena( mSlotScratch, node.mSlot, mSlots[ node.mSlot ].mParent );
+			spliceSlots( node.mSlot + 1, node.mSlot, mSlotScratch.begin() + 1, mSlotScratch.end() );
+		}
+
+		// Rebuilds the post-order index from the whole arena.
+		inline void indexPostOrder()
+		{
+			mPostOrder.clear();
+			insertPostOrder( 0, (uint32_t)mSlots.size(), 0 );
+		}
+
+		// Removes the slots of "node"'s subtree from the arena.
+		inline void eraseSlots( const UiTreeT<T, P, F>& node )
+		{
+			if ( mArenaValid ) {
+				eraseSlots( node.mSlot, mSlots[ node.mSlot ].mEnd );
+			}
+		}
+
+		// Removes the slots of "node"'s descendants from the arena.
+		inline void eraseChildSlots( const UiTreeT<T, P, F>& node )
+		{
+			if ( mArenaValid ) {
+				eraseSlots( node.mSlot + 1, mSlots[ node.mSlot ].mEnd );
+			}
+		}
+
+		// Switching to or from the grid rebuilds it.
+		inline void setSpatialIndex( SpatialIndex index, float cellSize )
+		{
+			if ( mSpatialIndex == SpatialIndex_Grid ) {
+				for ( auto& iter : mNodes ) {
+					Grid::reset( *iter.second );
+				}
+				mGrid.clear();
+			}
+			mGrid.mCellSize	= cellSize;
+			mSpatialIndex	= index;
+			if ( mSpatialIndex == SpatialIndex_Grid ) {
+				for ( auto& iter : mNodes ) {
+					mGrid.queue( *iter.second );
+				}
+			}
+		}
+
+		// Re-inserts queued nodes into the grid.
+		inline void validateGrid()
+		{
+			for ( uint64_t id : mGrid.mQueue ) {
+				auto iter = mNodes.find( id );
+				if ( iter != mNodes.end() ) {
+					UiTreeT<T, P, F>& node				= *iter->second;
+					node.getSpatial()->mGridQueued	= false;
+					mGrid.erase( node );
+					node.validateBounds( mTransforms );
+					mGrid.insert( node );
+				}
+			}
+			mGrid.mQueue.clear();
+		}
+
+		// Removes a node from the active set in constant time.
+		inline void sleep( const UiTreeT<T, P, F>& node )
+		{
+			if ( mTransforms.owns( node ) ) {
+				mTransforms.sleep( node.mLane );
+			}
+		}
+
+		inline void wake( const UiTreeT<T, P, F>& node )
+		{
+			mTransforms.wake( node.getLane( mTransforms ) );
+		}
+
+		// Returns the tree's input state, or nullptr when input is compiled out.
+		inline RootInput* getInput()
+		{
+			return getInput( mInput );
+		}
+
+		static inline RootInput* getInput( RootInput& input )
+		{
+			return &input;
+		}
+
+		static inline RootInput* getInput( RootInputNone& )
+		{
+			return nullptr;
+		}
+
+		// Disconnects the root from the window. Also run when the registry is released.
+		inline void disconnectSignals()
+		{
+			mConnectionKeyDown.disconnect();
+			mConnectionKeyUp.disconnect();
+			mConnectionMouseDown.disconnect();
+			mConnectionMouseDrag.disconnect();
+			mConnectionMouseMove.disconnect();
+			mConnectionMouseUp.disconnect();
+			mConnectionMouseWheel.disconnect();
+			mConnectionResize.disconnect();
+			mConnectionTouchesBegan.disconnect();
+			mConnectionTouchesEnded.disconnect();
+			mConnectionTouchesMoved.disconnect();
+		}
+	private:
+		// Removes the slots in [begin, end), which share a parent, shifting the slots after them down.
+		inline void eraseSlots( uint32_t begin, uint32_t end )
+		{
+			if ( begin >= end ) {
+				return;
+			}
+			const uint32_t count	= end - begin;
+			const uint32_t parent	= mSlots[ begin ].mParent;
+			const uint32_t rank		= mSlots[ begin ].mPost + 1 - ( mSlots[ begin ].mEnd - begin );
+			mSlots.erase( mSlots.begin() + begin, mSlots.begin() + end );
+			mPostOrder.erase( mPostOrder.begin() + rank, mPostOrder.begin() + rank + count );
+			for ( uint32_t i = begin; i < (uint32_t)mSlots.size(); ++i ) {
+				Slot& slot = mSlots[ i ];
+				if ( slot.mParent != Handle_None && slot.mParent >= begin ) {
+					slot.mParent -= count;
+				}
+				slot.mEnd			-= count;
+				slot.mNode->mSlot	= i;
+			}
+			for ( uint32_t i = parent; i != Handle_None; i = mSlots[ i ].mParent ) {
+				mSlots[ i ].mEnd -= count;
+			}
+			renumberPostOrder( rank );
+		}
+
+		// Inserts slots numbered from "pos" under "parent", shifting the slots after them up.
+		template<typename I>
+		inline void spliceSlots( uint32_t pos, uint32_t parent, I first, I last )
+		{
+			const uint32_t count = (uint32_t)std::distance( first, last );
+			mSlots.insert( mSlots.begin() + pos, first, last );
+			for ( uint32_t i = pos + count; i < (uint32_t)mSlots.size(); ++i ) {
+				Slot& slot = mSlots[ i ];
+				if ( slot.mParent != Handle_None && slot.mParent >= pos ) {
+					slot.mParent += count;
+				}
+				slot.mEnd			+= count;
+				slot.mNode->mSlot	= i;
+			}
+
+			// Only the ancestors of the new slots follow them in 
+			// post-order, out of the slots before them.
+			uint32_t rank = pos;
+			for ( uint32_t i = parent; i != Handle_None; i = mSlots[ i ].mParent ) {
+				mSlots[ i ].mEnd += count;
+				--rank;
+			}
+			insertPostOrder( pos, pos + count, rank );
+		}
+
+		/*
+		 * Inserts the nodes in the slots [begin, end), a run of 
+		 * whole sibling subtrees, into the post-order index at 
+		 * "rank". Each slot is emitted once every slot inside its 
+		 * subtree has been.
+		 */
+		inline void insertPostOrder( uint32_t begin, uint32_t end, uint32_t rank )
+		{
+			auto iter = mPostOrder.insert( mPostOrder.begin() + rank, end - begin, nullptr );
+			mSlotStack.clear();
+			for ( uint32_t i = begin; i < end; ++i ) {
+				while ( !mSlotStack.empty() && mSlots[ mSlotStack.back() ].mEnd <= i ) {
+					*iter++ = mSlots[ mSlotStack.back() ].mNode;
+					mSlotStack.pop_back();
+				}
+				mSlotStack.push_back( i );
+			}
+			while ( !mSlotStack.empty() ) {
+				*iter++ = mSlots[ mSlotStack.back() ].mNode;
+				mSlotStack.pop_back();
+			}
+			renumberPostOrder( rank );
+		}
+
+		// Stores each node's rank from "rank" on in its slot.
+		inline void renumberPostOrder( uint32_t rank )
+		{
+			for ( uint32_t i = rank; i < (uint32_t)mPostOrder.size(); ++i ) {
+				mSlots[ mPostOrder[ i ]->mSlot ].mPost = i;
+			}
+		}
+	public:
+		double													mAccumulator;
+		bool													mArenaValid;
+		uint32_t												mBatchDepth;
+		ci::signals::Connection									mConnectionKeyDown;
+		ci::signals::Connection									mConnectionKeyUp;
+		ci::signals::Connection									mConnectionMouseDown;
+		ci::signals::Connection									mConnectionMouseDrag;
+		ci::signals::Connection									mConnectionMouseMove;
+		ci::signals::Connection									mConnectionMouseUp;
+		ci::signals::Connection									mConnectionMouseWheel;
+		ci::signals::Connection									mConnectionResize;
+		ci::signals::Connection									mConnectionTouchesBegan;
+		ci::signals::Connection									mConnectionTouchesEnded;
+		ci::signals::Connection									mConnectionTouchesMoved;
+		double													mFixedTimestep;
+		std::vector<uint32_t>									mFreeHandles;
+		std::vector<uint64_t>									mFreeIds;
+		Grid													mGrid;
+		std::vector<uint32_t>									mHandleGenerations;
+		std::vector<UiTreeT<T, P, F>*>							mHandleNodes;
+		RootInputType											mInput;
+		uint64_t												mNextId;
+		std::unordered_map<uint64_t, UiTreeT<T, P, F>*>			mNodes;
+		PointBatch												mPoints;
+		std::vector<UiTreeT<T, P, F>*>							mPostOrder;		// Nodes of the arena in post-order
+		bool													mRecycleIds;
+		bool													mRelinked;		// Set once setParent() links a node
+		std::vector<Slot>										mSlots;
+		std::vector<Slot>										mSlotScratch;
+		std::vector<uint32_t>									mSlotStack;
+		SpatialIndex											mSpatialIndex;
+		TransformStore&											mTransforms;		// Owned by the root
+		std::vector<Handle>										mUpdateHandles;
+		std::vector<uint8_t>									mUpdateMarks;		// Set by advance() at post-order ranks
+		UpdateMode												mUpdateMode;
+	};
+
+	/*
+	 * Bodies of the transform setters, which convert their 
+	 * arguments to this tree's transform types first. They 
+	 * write this node's lane of a channel in the root's store.
+	 */
+	template<typename A>
+	inline void assignValue( Channel<A> TransformStore::* channel, const typename A::Value& v, float speed )
+	{
+		TransformStore& store	= getTransforms();
+		Channel<A>& c			= store.*channel;
+		const uint32_t lane		= getLane( store );
+		if ( !hasFeature( UiTreeFeature_Animation ) ) {
+			c.mValue.set( lane, v );
+			invalidateWorldMatrix();
+			return;
+		}
+		c.mSpeed[ lane ]			= speed;
+		c.mVelocityDecay[ lane ]	= 0.0f;
+		c.mTarget.set( lane, v );
+		c.mVelocity.set( lane, typename A::Value( 0.0f ) );
+		if ( speed >= 1.0f ) {
+			c.mValue.set( lane, v );
+			invalidateWorldMatrix();
+		}
+		wake();
+	}
+
+	// Rotation only eases toward its new target, keeping its velocity.
+	inline void assignRotation( const RotationType& r, float speed )
+	{
+		TransformStore& store	= getTransforms();
+		Channel<RotationArray>& c	= store.mRotation;
+		const uint32_t lane		= getLane( store );
+		if ( !hasFeature( UiTreeFeature_Animation ) ) {
+			c.mValue.set( lane, r );
+			invalidateWorldMatrix();
+			return;
+		}
+		c.mSpeed[ lane ] = speed;
+		c.mTarget.set( lane, r );
+		wake();
+	}
+
+	// Velocity moves the target from the current value. Only trees with animation update it.
+	template<typename A>
+	inline void assignVelocity( Channel<A> TransformStore::* channel, const typename A::Value& v, float decay )
+	{
+		static_assert( ( F & UiTreeFeature_Animation ) != 0, "Velocities need UiTreeFeature_Animation" );
+		TransformStore& store	= getTransforms();
+		Channel<A>& c			= store.*channel;
+		const uint32_t lane		= getLane( store );
+		c.mSpeed[ lane ]			= 1.0f;
+		c.mVelocityDecay[ lane ]	= decay;
+		c.mTarget.set( lane, c.mValue.get( lane ) );
+		c.mVelocity.set( lane, v );
+		wake();
+	}
+
+	// Readers of this node's lane of a channel, which report a node at rest without animation.
+	template<typename A>
+	inline typename A::Value getLaneValue( Channel<A> TransformStore::* channel ) const
+	{
+		TransformStore& store = getTransforms();
+		return ( store.*channel ).mValue.get( getLane( store ) );
+	}
+
+	template<typename A>
+	inline float getLaneSpeed( Channel<A> TransformStore::* channel ) const
+	{
+		if ( !hasFeature( UiTreeFeature_Animation ) ) {
+			return 1.0f;
+		}
+		TransformStore& store = getTransforms();
+		return ( store.*channel ).mSpeed[ getLane( store ) ];
+	}
+
+	template<typename A>
+	inline typename A::Value getLaneTarget( Channel<A> TransformStore::* channel ) const
+	{
+		if ( !hasFeature( UiTreeFeature_Animation ) ) {
+			return getLaneValue( channel );
+		}
+		TransformStore& store = getTransforms();
+		return ( store.*channel ).mTarget.get( getLane( store ) );
+	}
+
+	template<typename A>
+	inline typename A::Value getLaneVelocity( Channel<A> TransformStore::* channel, const typename A::Value& zero ) const
+	{
+		if ( !hasFeature( UiTreeFeature_Animation ) ) {
+			return zero;
+		}
+		TransformStore& store = getTransforms();
+		return ( store.*channel ).mVelocity.get( getLane( store ) );
+	}
+
+	template<typename A>
+	inline float getLaneVelocityDecay( Channel<A> TransformStore::* channel ) const
+	{
+		if ( !hasFeature( UiTreeFeature_Animation ) ) {
+			return 0.0f;
+		}
+		TransformStore& store = getTransforms();
+		return ( store.*channel ).mVelocityDecay[ getLane( store ) ];
+	}
+
+	// Returns the root's transform store, creating it on first use.
+	inline TransformStore& getTransforms() const
+	{
+		UiTreeT<T, P, F>& root = const_cast<UiTreeT<T, P, F>&>( getRoot() );
+		if ( root.mTransforms == nullptr ) {
+			root.mTransforms.reset( new TransformStore() );
+		}
+		return *root.mTransforms;
+	}
+
+	// Returns this node's lane in "store", the root's, acquiring one on first use.
+	inline uint32_t getLane( TransformStore& store ) const
+	{
+		if ( !store.owns( *this ) ) {
+			store.acquire( *this );
+		}
+		return mLane;
+	}
+
+	// Gives this node's lane back to the root's store.
+	inline void releaseLane()
+	{
+		UiTreeT<T, P, F>& root = getRoot();
+		if ( root.mTransforms != nullptr && root.mTransforms->owns( *this ) ) {
+			root.mTransforms->release( mLane );
+		}
+	}
+
+	// Copies rhs's transform into this node's lane, from whichever store holds it.
+	inline void copyLane( const UiTreeT<T, P, F>& rhs )
+	{
+		TransformStore& store			= getTransforms();
+		const uint32_t lane				= getLane( store );
+		const UiTreeT<T, P, F>& root	= rhs.getRoot();
+		if ( root.mTransforms != nullptr && root.mTransforms->owns( rhs ) ) {
+			store.copy( lane, *root.mTransforms, rhs.mLane );
+		} else {
+			store.clear( lane );
+		}
+	}
+
+	// Calls this node's policy and handlers for "E", if it has any.
+	template<EventType E, typename... A>
+	inline void emit( A&&... args )
+	{
+		EventHandlers* handlers = getEventHandlers();
+		if ( handlers != nullptr ) {
+			handlers->template emit<E>( this, args... );
+		}
+	}
+
+	/*
+	 * Accessors for this node's handler table, which is null 
+	 * until a handler is added.
+	 */
+	inline EventHandlers* acquireEventHandlers()
+	{
+		if ( mEventHandlers == nullptr ) {
+			mEventHandlers.reset( new EventHandlers() );
+		}
+		return mEventHandlers.get();
+	}
+
+	inline EventHandlers* getEventHandlers() const
+	{
+		return mEventHandlers.get();
+	}
+
+	// Replaces the handler table with a copy of "source", or frees it when "source" is null.
+	inline void resetEventHandlers( const EventHandlers* source )
+	{
+		mEventHandlers.reset( source == nullptr ? nullptr : new EventHandlers( *source ) );
+	}
+
+	// Frees the handler table once nothing is left in it.
+	inline void releaseEventHandlers()
+	{
+		if ( getEventHandlers()->empty() ) {
+			resetEventHandlers( nullptr );
+		}
+		invalidateRoutes();
+	}
+
+	// Removes every handler, or the handler connected for "type".
+	inline void removeEventHandlers()
+	{
+		EventHandlers* handlers = getEventHandlers();
+		if ( handlers != nullptr ) {
+			handlers->clear();
+			releaseEventHandlers();
+		}
+	}
+
+	inline void removeEventHandlers( EventType type )
+	{
+		EventHandlers* handlers = getEventHandlers();
+		if ( handlers != nullptr ) {
+			handlers->remove( type );
+			releaseEventHandlers();
+		}
+	}
+
+	/*
+	 * Accessors for the input state of this node and of its 
+	 * tree. Both return nullptr when input is compiled out, so 
+	 * the same code builds either way and the dead branches 
+	 * fold away.
+	 */
+	inline Input* getInput()
+	{
+		return getInput( mState.mInput );
+	}
+
+	inline const Input* getInput() const
+	{
+		return getInput( const_cast<InputType&>( mState.mInput ) );
+	}
+
+	static inline Input* getInput( Input& input )
+	{
+		return &input;
+	}
+
+	static inline Input* getInput( InputNone& )
+	{
+		return nullptr;
+	}
+
+	inline const RootInput* getRootInput() const
+	{
+		return const_cast<UiTreeT<T, P, F>*>( this )->getRegistry().getInput();
+	}
+
+	// Returns this node's hit test caches, or nullptr when the spatial index is compiled out.
+	inline Spatial* getSpatial() const
+	{
+		return getSpatial( mSpatial );
+	}
+
+	static inline Spatial* getSpatial( Spatial& spatial )
+	{
+		return &spatial;
+	}
+
+	static inline Spatial* getSpatial( SpatialNone& )
+	{
+		return nullptr;
+	}
+
+	// Returns the routes of this subtree. Every route is open when input is compiled out.
+	inline uint16_t getRoutes() const
+	{
+		const Input* input = getInput();
+		return input == nullptr ? (uint16_t)~0 : input->mRoutes;
+	}
+
+	// Replaces the handler connected for "E" with "eventHandler". Fails to compile for events this tree type never sends.
+	template<EventType E, typename H>
+	inline void setEventHandler( const H& eventHandler )
+	{
+		static_assert( ( getEventTypes() & ( 1u << E ) ) != 0, "This tree type was built without the input feature these events need" );
+		setEventHandler( E, eventHandler );
+	}
+
+	// Connects "eventHandler" to events of type "E", unless this tree type never sends them.
+	template<EventType E, typename H>
+	inline void connectSentEventHandler( const H& eventHandler )
+	{
+		connectSentEventHandler<E>( eventHandler, std::integral_constant<bool, ( getEventTypes() & ( 1u << E ) ) != 0>() );
+	}
+
+	template<EventType E, typename H>
+	inline void connectSentEventHandler( const H& eventHandler, std::true_type )
+	{
+		setEventHandler<E>( EventHandler<E>( eventHandler ) );
+	}
+
+	template<EventType E, typename H>
+	inline void connectSentEventHandler( const H&, std::false_type )
+	{
+	}
+
+	// Replaces the handler connected for "type" with "eventHandler". Handlers added with addEventHandler() stay.
+	template<typename H>
+	inline void setEventHandler( EventType type, const H& eventHandler )
+	{
+		if ( !eventHandler ) {
+			removeEventHandlers( type );
+			return;
+		}
+		acquireEventHandlers()->connect( type, eventHandler );
+		invalidateRoutes();
+		if ( type == EventType_Update ) {
+			wake();
+		}
+	}
+
+	/*
+	 * Sends a key event to the focused node, then to each of its 
+	 * ancestors until one handles it. A disabled node keeps the 
+	 * event from its descendants, as a broadcast would, so the 
+	 * event starts above the highest disabled node. Returns 
+	 * false if nothing is focused.
+	 */
+	template<EventType E>
+	inline bool bubbleKeyEvent( ci::app::KeyEvent& event )
+	{
+		UiTreeT<T, P, F>* node = getFocusedNode();
+		if ( node == nullptr ) {
+			return false;
+		}
+		for ( UiTreeT<T, P, F>* iter = node; iter != nullptr; iter = iter->mParent ) {
+			if ( !iter->mState.mEnabled ) {
+				node = iter->mParent;
+			}
+		}
+		while ( node != nullptr && !event.isHandled() ) {
+			UiTreeT<T, P, F>* parent = node->mParent;
+			node->emit<E>( event );
+			node = parent;
+		}
+		return true;
+	}
+
+	inline void dragMouse( ci::app::MouseEvent& event )
+	{
+		hover( ci::vec2( event.getPos() ) );
+		if ( !dragCaptured( event ) ) {
+			mouseDrag( event );
+		}
+	}
+
+	inline void moveMouse( ci::app::MouseEvent& event )
+	{
+		hover( ci::vec2( event.getPos() ) );
+		mouseMove( event );
+	}
+
+	/*
+	 * Queues a mouse move or drag in place of the one already 
+	 * queued. A drag following a move, or the reverse, flushes 
+	 * the queue first. Returns false if input is not coalesced.
+	 */
+	inline bool queueMouse( const ci::app::MouseEvent& event, bool drag )
+	{
+		RootInput* input = getRegistry().getInput();
+		if ( input == nullptr || input->mInputMode == InputMode_Immediate ) {
+			return false;
+		}
+		if ( input->mMouseQueued && input->mMouseQueuedDrag != drag ) {
+			flushInput();
+		}
+		input->mMouseQueue		= event;
+		input->mMouseQueued		= true;
+		input->mMouseQueuedDrag	= drag;
+		if ( input->mInputMode == InputMode_Samples ) {
+			input->mMouseSamples.push_back( ci::vec2( event.getPos() ) );
+		}
+		return true;
+	}
+
+	/*
+	 * Merges moved touches into the queue, one entry per touch 
+	 * ID. A merged touch keeps the previous position of the 
+	 * first move queued, so touch over and out events span the 
+	 * whole frame. Returns false if input is not coalesced.
+	 */
+	inline bool queueTouches( const ci::app::TouchEvent& event )
+	{
+		RootInput* input = getRegistry().getInput();
+		if ( input == nullptr || input->mInputMode == InputMode_Immediate ) {
+			return false;
+		}
+		input->mTouchQueueWindow = event.getWindow();
+		for ( const ci::app::TouchEvent::Touch& touch : event.getTouches() ) {
+			auto iter = std::find_if( input->mTouchQueue.begin(), input->mTouchQueue.end(), 
+				[ & ]( const ci::app::TouchEvent::Touch& t ) { return t.getId() == touch.getId(); } );
+			if ( iter == input->mTouchQueue.end() ) {
+				input->mTouchQueue.push_back( touch );
+			} else {
+				*iter = ci::app::TouchEvent::Touch( touch.getPos(), iter->getPrevPos(), 
+					touch.getId(), touch.getTime(), const_cast<void*>( touch.getNative() ) );
+			}
+			if ( input->mInputMode == InputMode_Samples ) {
+				input->mTouchSamples[ touch.getId() ].push_back( touch.getPos() );
+			}
+		}
+		return true;
+	}
+
+	// Sends a drag to the node capturing the mouse. Returns false if no node has the capture.
+	inline bool dragCaptured( ci::app::MouseEvent& event )
+	{
+		RootInput* input		= getRegistry().getInput();
+		UiTreeT<T, P, F>* node	= input == nullptr ? nullptr : 
+			const_cast<UiTreeT<T, P, F>*>( lookup( input->mPointerCaptureId ) );
+		if ( node == nullptr ) {
+			return false;
+		}
+		if ( node->mState.mEnabled ) {
+			node->emit<EventType_MouseDrag>( event );
+		}
+		return true;
+	}
+
+	/*
+	 * Sends captured touches to their capturing nodes, grouped 
+	 * into one event per node, and broadcasts the rest through 
+	 * the tree.
+	 */
+	inline void moveTouches( ci::app::TouchEvent& event )
+	{
+		RootInput* input = getRegistry().getInput();
+		if ( input == nullptr ) {
+			return;
+		}
+		trackTouches( event.getTouches(), false );
+		if ( input->mTouchCaptureIds.empty() ) {
+			touchesMoved( event );
+			return;
+		}
+
+		std::vector<std::pair<UiTreeT<T, P, F>*, std::vector<ci::app::TouchEvent::Touch>>> captured;
+		std::vector<ci::app::TouchEvent::Touch> touches;
+		for ( const ci::app::TouchEvent::Touch& touch : event.getTouches() ) {
+			auto iter				= input->mTouchCaptureIds.find( touch.getId() );
+			UiTreeT<T, P, F>* node	= iter == input->mTouchCaptureIds.end() ? nullptr : 
+				const_cast<UiTreeT<T, P, F>*>( lookup( iter->second ) );
+			if ( node == nullptr ) {
+				touches.push_back( touch );
+				continue;
+			}
+			size_t i = 0;
+			while ( i < captured.size() && captured[ i ].first != node ) {
+				++i;
+			}
+			if ( i == captured.size() ) {
+				captured.push_back( std::make_pair( node, std::vector<ci::app::TouchEvent::Touch>() ) );
+			}
+			captured[ i ].second.push_back( touch );
+		}
+
+		for ( auto& iter : captured ) {
+			UiTreeT<T, P, F>* node = iter.first;
+			if ( node->mState.mEnabled && node->hasEventHandler( EventType_TouchesMoved ) ) {
+				ci::app::TouchEvent e( event.getWindow(), iter.second );
+				node->emit<EventType_TouchesMoved>( e );
+			}
+		}
+		if ( touches.size() == event.getTouches().size() ) {
+			touchesMoved( event );
+		} else if ( !touches.empty() ) {
+			ci::app::TouchEvent e( event.getWindow(), touches );
+			touchesMoved( e );
+		}
+	}
+
+	inline void keyDown( ci::app::KeyEvent& event )
+	{
+		if ( mState.mEnabled ) {
+			for ( auto& iter : mChildren ) {
+				if ( ( iter.second.getRoutes() & Route_KeyDown ) == 0 ) {
+					continue;
+				}
+				iter.second.keyDown( event );
+				if ( event.isHandled() ) {
+					return;
+				}
+			}
+			emit<EventType_KeyDown>( event );
+		}
+	}
+
+	inline void keyUp( ci::app::KeyEvent& event )
+	{
+		if ( mState.mEnabled ) {
+			for ( auto& iter : mChildren ) {
+				if ( ( iter.second.getRoutes() & Route_KeyUp ) == 0 ) {
+					continue;
+				}
+				iter.second.keyUp( event );
+				if ( event.isHandled() ) {
+					return;
+				}
+			}
+			emit<EventType_KeyUp>( event );
+		}
+	}
+
+	inline void mouseDown( ci::app::MouseEvent& event )
+	{
+		if ( mState.mEnabled ) {
+			bool handled = false;
+			for ( auto& iter : mChildren ) {
+				if ( ( iter.second.getRoutes() & Route_MouseDown ) == 0 ) {
+					continue;
+				}
+				iter.second.mouseDown( event );
+				if ( event.isHandled() ) {
+					handled = true;
+					return;
+				}
+			}
+			if ( !handled ) {
+				emit<EventType_MouseDown>( event );
+			}
+		}
+	}
+
+	inline void mouseDrag( ci::app::MouseEvent& event )
+	{
+		if ( mState.mEnabled ) {
+			bool handled = false;
+			for ( auto& iter : mChildren ) {
+				if ( ( iter.second.getRoutes() & Route_MouseDrag ) == 0 ) {
+					continue;
+				}
+				iter.second.mouseDrag( event );
+				if ( event.isHandled() ) {
+					handled = true;
+					return;
+				}
+			}
+			if ( !handled ) {
+				emit<EventType_MouseDrag>( event );
+			}
+		}
+	}
+
+	inline void mouseMove( ci::app::MouseEvent& event )
+	{
+		if ( mState.mEnabled ) {
+			bool handled = false;
+			for ( auto& iter : mChildren ) {
+				if ( ( iter.second.getRoutes() & Route_MouseMove ) == 0 ) {
+					continue;
+				}
+				iter.second.mouseMove( event );
+				if ( event.isHandled() ) {
+					handled = true;
+					break;
+				}
+			}
+			if ( !handled ) {
+				emit<EventType_MouseMove>( event );
+			}
+		}
+	}
+
+	/*
+	 * Updates hover state for a pointer at "v". The root keeps 
+	 * the hovered path from itself to the deepest node under the 
+	 * pointer. Only nodes that join or leave the path change 
+	 * state, deepest first, so the cost follows the tree's depth.
+	 */
+	inline void hover( const ci::vec2& v )
+	{
+		RootInput* input = getRegistry().getInput();
+		if ( input == nullptr ) {
+			return;
+		}
+
+		// Both paths are swapped out of the root's buffers and back, 
+		// so a call allocates nothing once the buffers have grown.
+		std::vector<uint64_t> path;
+		std::vector<uint64_t> previous;
+		path.swap( input->mHoverScratch );
+		previous.swap( input->mHoverPath );
+		calcPath( v, path );
+
+		size_t common = 0;
+		while ( common < path.size() && common < previous.size() && path[ common ] == previous[ common ] ) {
+			++common;
+		}
+
+		// Nodes are looked up again before each change, as handlers may remove them.
+		for ( size_t i = previous.size(); i-- > common; ) {
+			UiTreeT<T, P, F>* node = const_cast<UiTreeT<T, P, F>*>( lookup( previous[ i ] ) );
+			if ( node != nullptr && node->getInput()->mMouseOver ) {
+				node->getInput()->mMouseOver = false;
+				node->emit<EventType_MouseOut>();
+			}
+		}
+		for ( size_t i = path.size(); i-- > 0; ) {
+			UiTreeT<T, P, F>* node = const_cast<UiTreeT<T, P, F>*>( lookup( path[ i ] ) );
+			if ( node != nullptr && !node->getInput()->mMouseOver ) {
+				node->getInput()->mMouseOver = true;
+				node->emit<EventType_MouseOver>();
+			}
+		}
+
+		// Handlers may have replaced the registry.
+		input = getRegistry().getInput();
+		input->mHoverPath.swap( path );
+		input->mHoverScratch.swap( previous );
+	}
+
+	/*
+	 * Fills "path" with the IDs of the nodes under the world space 
+	 * point "v", from this node down. At each level the path 
+	 * follows the first child, in preorder, whose subtree is hit, 
+	 * with every node tested as its own collision type. The path 
+	 * ends at a disabled node.
+	 */
+	inline void calcPath( const ci::vec2& v, std::vector<uint64_t>& path )
+	{
+		Registry& registry = getArena();
+		if ( registry.mSpatialIndex == SpatialIndex_Bvh ) {
+			validateBounds();
+		}
+
+		path.clear();
+		const ci::vec3 p( v, 0.0f );
+		uint32_t begin	= mSlot;
+		uint32_t end	= registry.mSlots[ mSlot ].mEnd;
+		uint32_t last	= registry.mSlots[ mSlot ].mParent;
+		while ( true ) {
+			const uint32_t hit = calcFirstHit( registry, begin, end, p, nullptr );
+			if ( hit == end ) {
+				break;
+			}
+			const size_t size = path.size();
+			for ( uint32_t i = hit; i != last; i = registry.mSlots[ i ].mParent ) {
+				path.push_back( registry.mSlots[ i ].mNode->mId );
+			}
+			std::reverse( path.begin() + size, path.end() );
+			begin	= hit + 1;
+			end		= registry.mSlots[ hit ].mEnd;
+			last	= hit;
+		}
+		for ( size_t i = 0; i < path.size(); ++i ) {
+			if ( !lookup( path[ i ] )->mState.mEnabled ) {
+				path.resize( i );
+				break;
+			}
+		}
+	}
+
+	/*
+	 * Updates the root's touch paths once per touch event. Nodes 
+	 * joining a touch's path receive touch over, and nodes leaving 
+	 * it receive touch out, deepest first. An ended touch leaves 
+	 * every node on its path. Each node's touch list is refilled 
+	 * once the paths are updated.
+	 */
+	inline void trackTouches( const std::vector<ci::app::TouchEvent::Touch>& touches, bool ended )
+	{
+		RootInput* input = getRegistry().getInput();
+		if ( input == nullptr ) {
+			return;
+		}
+
+		// Paths trade buffers with the root's scratch buffer and 
+		// their table entries, as in hover(), so a touch event 
+		// allocates nothing once the buffers have grown.
+		for ( const ci::app::TouchEvent::Touch& touch : touches ) {
+			const uint32_t id = touch.getId();
+			std::vector<uint64_t> path;
+			std::vector<uint64_t> previous;
+			path.swap( input->mTouchScratch );
+			path.clear();
+			if ( !ended ) {
+				calcPath( touch.getPos(), path );
+			}
+
+			auto iter = input->mTouchPaths.find( id );
+			if ( iter != input->mTouchPaths.end() ) {
+				previous.swap( iter->second.mPath );
+				if ( ended ) {
+					input->mTouchPaths.erase( iter );
+				} else {
+					iter->second.mTouch = touch;
+				}
+			} else if ( !ended ) {
+				input->mTouchPaths.insert( std::make_pair( id, TouchPath( touch ) ) );
+			}
+
+			size_t common = 0;
+			while ( common < path.size() && common < previous.size() && path[ common ] == previous[ common ] ) {
+				++common;
+			}
+			for ( size_t i = previous.size(); i-- > common; ) {
+				UiTreeT<T, P, F>* node = const_cast<UiTreeT<T, P, F>*>( lookup( previous[ i ] ) );
+				if ( node != nullptr ) {
+					node->emit<EventType_TouchOut>( id );
+				}
+			}
+			for ( size_t i = path.size(); i-- > common; ) {
+				UiTreeT<T, P, F>* node = const_cast<UiTreeT<T, P, F>*>( lookup( path[ i ] ) );
+				if ( node != nullptr ) {
+					node->emit<EventType_TouchOver>( id );
+				}
+			}
+
+			// Handlers may have removed nodes on the path, or replaced the registry.
+			for ( size_t i = 0; i < path.size(); ++i ) {
+				if ( lookup( path[ i ] ) == nullptr ) {
+					path.resize( i );
+					break;
+				}
+			}
+			input	= getRegistry().getInput();
+			iter	= input->mTouchPaths.find( id );
+			if ( iter != input->mTouchPaths.end() ) {
+				iter->second.mPath.swap( path );
+			}
+			input->mTouchScratch.swap( previous );
+		}
+		input->collectTouches();
+	}
+
+	inline void mouseUp( ci::app::MouseEvent& event )
+	{
+		if ( mState.mEnabled ) {
+			bool handled = false;
+			for ( auto& iter : mChildren ) {
+				if ( ( iter.second.getRoutes() & Route_MouseUp ) == 0 ) {
+					continue;
+				}
+				iter.second.mouseUp( event );
+				if ( event.isHandled() ) {
+					handled = true;
+					break;
+				}
+			}
+			if ( !handled ) {
+				emit<EventType_MouseUp>( event );
+			}
+		}
+	}
+
+	inline void mouseWheel( ci::app::MouseEvent& event )
+	{
+		if ( mState.mEnabled ) {
+			for ( auto& iter : mChildren ) {
+				if ( ( iter.second.getRoutes() & Route_MouseWheel ) == 0 ) {
+					continue;
+				}
+				iter.second.mouseWheel( event );
+				if ( event.isHandled() ) {
+					return;
+				}
+			}
+			emit<EventType_MouseWheel>( event );
+		}
+	}
+	
+	inline void resize()
+	{
+		if ( mState.mEnabled ) {
+			for ( auto& iter : mChildren ) {
+				if ( ( iter.second.getRoutes() & Route_Resize ) == 0 ) {
+					continue;
+				}
+				iter.second.resize();
+			}
+			emit<EventType_Resize>();
+		}
+	}
+	
+	inline void touchesBegan( ci::app::TouchEvent& event )
+	{
+		if ( mState.mEnabled ) {
+			bool handled = false;
+			for ( auto& iter : mChildren ) {
+				if ( ( iter.second.getRoutes() & Route_TouchesBegan ) == 0 ) {
+					continue;
+				}
+				iter.second.touchesBegan( event );
+				if ( event.isHandled() ) {
+					handled = true;
+					break;
+				}
+			}
+			if ( !handled ) {
+				emit<EventType_TouchesBegan>( event );
+			}
+		}
+	}
+
+	inline void touchesEnded( ci::app::TouchEvent& event )
+	{
+		if ( mState.mEnabled ) {
+			bool handled = false;
+			for ( auto& iter : mChildren ) {
+				if ( ( iter.second.getRoutes() & Route_TouchesEnded ) == 0 ) {
+					continue;
+				}
+				iter.second.touchesEnded( event );
+				if ( event.isHandled() ) {
+					handled = true;
+					break;
+				}
+			}
+			if ( !handled ) {
+				emit<EventType_TouchesEnded>( event );
+			}
+		}
+	}
+
+	inline void touchesMoved( ci::app::TouchEvent& event )
+	{
+		if ( mState.mEnabled ) {
+			bool handled = false;
+			for ( auto& iter : mChildren ) {
+				if ( ( iter.second.getRoutes() & Route_TouchesMoved ) == 0 ) {
+					continue;
+				}
+				iter.second.touchesMoved( event );
+				if ( event.isHandled() ) {
+					handled = true;
+					break;
+				}
+			}
+			if ( !handled ) {
+				emit<EventType_TouchesMoved>( event );
+			}
+		}
+	}
+
+	// Connects the root to the window, replacing any connections it already holds.
+	inline void connectSignals()
+	{
+		disconnectSignals();
+		ci::app::WindowRef window = ci::app::getWindow();
+		if ( window == nullptr ) {
+			return;
+		}
+		Registry& registry = getRegistry();
+		if ( hasFeature( UiTreeFeature_Keyboard ) ) {
+			registry.mConnectionKeyDown = window->getSignalKeyDown().connect( 1, 
+				[ this ]( ci::app::KeyEvent& event )
+			{
+				if ( !bubbleKeyEvent<EventType_KeyDown>( event ) ) {
+					keyDown( event );
+				}
+			} );
+			registry.mConnectionKeyUp = window->getSignalKeyUp().connect( 1, 
+				[ this ]( ci::app::KeyEvent& event )
+			{
+				if ( !bubbleKeyEvent<EventType_KeyUp>( event ) ) {
+					keyUp( event );
+				}
+			} );
+		}
+		if ( hasFeature( UiTreeFeature_Mouse ) ) {
+			registry.mConnectionMouseDown = window->getSignalMouseDown().connect( 1, 
+				[ this ]( ci::app::MouseEvent& event ) { flushInput(); hover( ci::vec2( event.getPos() ) ); mouseDown( event ); } );
+			registry.mConnectionMouseDrag = window->getSignalMouseDrag().connect( 1, 
+				[ this ]( ci::app::MouseEvent& event )
+			{
+				if ( !queueMouse( event, true ) ) {
+					dragMouse( event );
+				}
+			} );
+			registry.mConnectionMouseMove = window->getSignalMouseMove().connect( 1, 
+				[ this ]( ci::app::MouseEvent& event )
+			{
+				if ( !queueMouse( event, false ) ) {
+					moveMouse( event );
+				}
+			} );
+			registry.mConnectionMouseUp = window->getSignalMouseUp().connect( 1, 
+				[ this ]( ci::app::MouseEvent& event )
+			{
+				flushInput();
+				hover( ci::vec2( event.getPos() ) );
+				mouseUp( event );
+				getRegistry().getInput()->mPointerCaptureId = Id_None;
+			} );
+			registry.mConnectionMouseWheel = window->getSignalMouseWheel().connect( 1, 
+				[ this ]( ci::app::MouseEvent& event ) { flushInput(); mouseWheel( event ); } );
+		}
+		registry.mConnectionResize = window->getSignalResize().connect( 1, 
+			[ this ]() { resize(); } );
+		if ( hasFeature( UiTreeFeature_Touch ) ) {
+			registry.mConnectionTouchesBegan = window->getSignalTouchesBegan().connect( 1, 
+				[ this ]( ci::app::TouchEvent& event )
+			{
+				flushInput();
+				trackTouches( event.getTouches(), false );
+				touchesBegan( event );
+			} );
+			registry.mConnectionTouchesEnded = window->getSignalTouchesEnded().connect( 1, 
+				[ this ]( ci::app::TouchEvent& event )
+			{
+				flushInput();
+				trackTouches( event.getTouches(), true );
+				touchesEnded( event );
+				for ( const ci::app::TouchEvent::Touch& touch : event.getTouches() ) {
+					getRegistry().getInput()->mTouchCaptureIds.erase( touch.getId() );
+				}
+			} );
+			registry.mConnectionTouchesMoved = window->getSignalTouchesMoved().connect( 1, 
+				[ this ]( ci::app::TouchEvent& event )
+			{
+				if ( !queueTouches( event ) ) {
+					moveTouches( event );
+				}
+			} );
+		}
+	}
+
+	inline void disconnectSignals()
+	{
+		if ( mRegistry != nullptr ) {
+			mRegistry->disconnectSignals();
+		}
+	}
+
+	// Removes all children, keeping the tree's index in sync.
+	inline void clearChildren()
+	{
+		Registry& registry = getRegistry();
+		registry.eraseChildSlots( *this );
+		for ( auto& iter : mChildren ) {
+			iter.second.unregisterNodes( registry );
+		}
+		mChildren.clear();
+		invalidateRoutes();
+	}
+
+	/*
+	 * Removes this node's descendants from the index of the tree 
+	 * this node belongs to, before they are moved elsewhere.
+	 */
+	inline void detachChildren()
+	{
+		if ( mParent == nullptr ) {
+			mRegistry.reset();
+		} else {
+			Registry& registry = getRegistry();
+			registry.eraseChildSlots( *this );
+			for ( auto& iter : mChildren ) {
+				iter.second.unregisterNodes( registry );
+			}
+		}
+	}
+
+	/*
+	 * Deep copies rhs's state and children in a single pass, 
+	 * linking each copied child to its new parent. Descendants 
+	 * are renumbered from "registry" when one is supplied. Keeps 
+	 * this node's parent and does not touch either tree's index 
+	 * or window signals.
+	 */
+	inline void copyFrom( const UiTreeT<T, P, F>& rhs, Registry* registry )
+	{
+		std::map<uint64_t, UiTreeT<T, P, F>> children;
+		for ( const auto& iter : rhs.mChildren ) {
+			uint64_t id				= registry == nullptr ? iter.first : registry->acquireId();
+			UiTreeT<T, P, F>& child	= children[ id ];
+			child.mParent			= this;
+			child.copyFrom( iter.second, registry );
+			child.mId				= id;
+		}
+
+		mId								= rhs.mId;
+		mState							= rhs.mState;
+		mWorldDirty						= true;
+		invalidateBounds();
+		resetEventHandlers( rhs.getEventHandlers() );
+		copyLane( rhs );
+
+		// The copy is not under the pointer until the next hover.
+		Input* input = getInput();
+		if ( input != nullptr ) {
+			input->mMouseOver = false;
+		}
+
+		// Old children are released last, in case rhs is one of them.
+		mChildren.swap( children );
+	}
+
+	/*
+	 * Takes over rhs's state and children, relinking the children 
+	 * to this node. Transform lanes follow the nodes into this 
+	 * node's store, so this node's parent must be set first. 
+	 * Leaves rhs empty and disabled without firing its handlers. 
+	 * Does not touch either tree's index.
+	 */
+	inline void moveFrom( UiTreeT<T, P, F>& rhs )
+	{
+		rhs.disconnectSignals();
+		moveLanes( rhs );
+
+		mChildren						= std::move( rhs.mChildren );
+		mEventHandlers					= std::move( rhs.mEventHandlers );
+		mId								= rhs.mId;
+		mState							= std::move( rhs.mState );
+		mWorldDirty						= true;
+		invalidateBounds();
+
+		for ( auto& iter : mChildren ) {
+			iter.second.mParent = this;
+			iter.second.invalidateWorldMatrix();
+		}
+
+		rhs.mChildren.clear();
+		rhs.mState.mEnabled = false;
+		rhs.disconnectEventHandlers();
+	}
+
+	/*
+	 * Hands rhs's lane to this node, and moves the lanes of rhs's 
+	 * descendants into this node's store if they live in another.
+	 */
+	inline void moveLanes( UiTreeT<T, P, F>& rhs )
+	{
+		TransformStore& store		= getTransforms();
+		UiTreeT<T, P, F>& root		= rhs.getRoot();
+		TransformStore* source		= root.mTransforms.get();
+		if ( store.owns( rhs ) ) {
+			if ( store.owns( *this ) ) {
+				store.release( mLane );
+			}
+			mLane						= rhs.mLane;
+			store.mNodes[ mLane ]		= this;
+			rhs.mLane					= Handle_None;
+		} else {
+			copyLane( rhs );
+			if ( source != nullptr && source->owns( rhs ) ) {
+				source->release( rhs.mLane );
+			}
+		}
+		if ( source != nullptr && source != &store ) {
+			for ( auto& iter : rhs.mChildren ) {
+				iter.second.moveLanes( *source, store );
+			}
+		}
 	}
 
-	inline UiTreeT<T>& disconnectTouchesEndedEventHandler()
+	inline void moveLanes( TransformStore& source, TransformStore& store )
 	{
-		mEventHandlerTouchesEnded = nullptr;
-		return *this;
-	}
+		if ( source.owns( *this ) ) {
+			const uint32_t from	= mLane;
+			const bool awake	= from < source.mAwake;
+			const uint32_t lane	= store.acquire( *this );
+			store.copy( lane, source, from );
 
-	inline UiTreeT<T>& connectTouchesMovedEventHandler( const std::function<void( UiTreeT<T>*, ci::app::TouchEvent& )>& eventHandler )
-	{
-		mEventHandlerTouchesMoved = eventHandler;
-		return *this;
-	}
-	
-	template<typename V, typename Y>
-	inline UiTreeT<T>& connectTouchesMovedEventHandler( V eventHandler, Y* eventHandlerObject )
-	{
-		return connectTouchesMovedEventHandler( std::bind( eventHandler, eventHandlerObject, std::placeholders::_1, std::placeholders::_2 ) );
+			// Releasing swaps lanes through this node, so its new lane is restored after.
+			source.release( from );
+			mLane = lane;
+			if ( awake ) {
+				store.wake( lane );
+			}
+		}
+		for ( auto& iter : mChildren ) {
+			iter.second.moveLanes( source, store );
+		}
 	}
 
-	inline UiTreeT<T>& disconnectTouchesMovedEventHandler()
+	inline size_t calcNumNodes( size_t count ) const
 	{
-		mEventHandlerTouchesMoved = nullptr;
-		return *this;
+		for ( auto& iter : mChildren ) {
+			count = iter.second.calcNumNodes( count );
+		}
+		return count + 1;
 	}
 
-	inline UiTreeT<T>& connectTouchOutEventHandler( const std::function<void( UiTreeT<T>*, uint32_t )>& eventHandler )
+	// Returns the root's registry, building it on first use.
+	inline Registry& getRegistry()
 	{
-		mEventHandlerTouchOut = eventHandler;
-		return *this;
+		UiTreeT<T, P, F>& root = getRoot();
+		if ( root.mRegistry == nullptr ) {
+			root.mRegistry.reset( new Registry( root.getTransforms() ) );
+			root.registerNodes( *root.mRegistry );
+		}
+		return *root.mRegistry;
+	}
+
+	/*
+	 * Returns the root's registry with its node arena up to date. 
+	 * Adding and removing nodes splices their slots in place, so 
+	 * the arena is only rebuilt after a batch commits or a root 
+	 * takes over another root's registry. Slots still shift when 
+	 * nodes are added or removed, including from inside a 
+	 * handler, so none may be held across a call that can run one.
+	 */
+	inline Registry& getArena()
+	{
+		Registry& registry = getRegistry();
+		if ( !registry.mArenaValid ) {
+			registry.mSlots.clear();
+			getRoot().buildArena( registry.mSlots, 0, Handle_None );
+			registry.indexPostOrder();
+			registry.mArenaValid = true;
+		}
+		return registry;
 	}
-	
-	template<typename V, typename Y>
-	inline UiTreeT<T>& connectTouchOutEventHandler( V eventHandler, Y* eventHandlerObject )
+
+	/*
+	 * Appends this subtree to "slots" depth-first, numbering its 
+	 * slots from "offset" and recalculating its routes.
+	 */
+	inline void buildArena( std::vector<Slot>& slots, uint32_t offset, uint32_t parent )
 	{
-		return connectTouchOutEventHandler( std::bind( eventHandler, eventHandlerObject, std::placeholders::_1, std::placeholders::_2 ) );
+		mSlot = offset + (uint32_t)slots.size();
+		slots.push_back( Slot( this, parent ) );
+		for ( auto& iter : mChildren ) {
+			iter.second.buildArena( slots, offset, mSlot );
+		}
+		Input* input = getInput();
+		if ( input != nullptr ) {
+			input->mRoutes = calcRoutes();
+			for ( const auto& iter : mChildren ) {
+				input->mRoutes |= iter.second.getRoutes();
+			}
+		}
+		slots[ mSlot - offset ].mEnd = offset + (uint32_t)slots.size();
 	}
 
-	inline UiTreeT<T>& disconnectTouchOutEventHandler()
+	// Returns the routes of the handlers connected to this node itself.
+	inline uint16_t calcRoutes() const
 	{
-		mEventHandlerTouchOut = nullptr;
-		return *this;
+		return ( hasEventHandler( EventType_KeyDown ) ? Route_KeyDown : 0 ) | 
+			( hasEventHandler( EventType_KeyUp ) ? Route_KeyUp : 0 ) | 
+			( hasEventHandler( EventType_MouseDown ) ? Route_MouseDown : 0 ) | 
+			( hasEventHandler( EventType_MouseDrag ) ? Route_MouseDrag : 0 ) | 
+			( hasEventHandler( EventType_MouseMove ) ? Route_MouseMove : 0 ) | 
+			( hasEventHandler( EventType_MouseUp ) ? Route_MouseUp : 0 ) | 
+			( hasEventHandler( EventType_MouseWheel ) ? Route_MouseWheel : 0 ) | 
+			( hasEventHandler( EventType_Resize ) ? Route_Resize : 0 ) | 
+			( hasEventHandler( EventType_TouchesBegan ) ? Route_TouchesBegan : 0 ) | 
+			( hasEventHandler( EventType_TouchesEnded ) ? Route_TouchesEnded : 0 ) | 
+			( hasEventHandler( EventType_TouchesMoved ) ? Route_TouchesMoved : 0 );
 	}
 
-	inline UiTreeT<T>& connectTouchOverEventHandler( const std::function<void( UiTreeT<T>*, uint32_t )>& eventHandler )
+	// Focuses the next or previous focus stop in the focused node's scope.
+	inline bool moveFocus( bool forward )
 	{
-		mEventHandlerTouchOver = eventHandler;
-		return *this;
+		Registry& registry	= getArena();
+		if ( registry.getInput() == nullptr ) {
+			return false;
+		}
+		UiTreeT<T, P, F>* focused	= getFocusedNode();
+		UiTreeT<T, P, F>* scope	= &getRoot();
+		if ( focused != nullptr ) {
+			for ( UiTreeT<T, P, F>* node = focused->mParent; node != nullptr; node = node->mParent ) {
+				if ( node->isFocusScope() ) {
+					scope = node;
+					break;
+				}
+			}
+		}
+
+		const uint32_t begin	= scope->mSlot;
+		const uint32_t count	= registry.mSlots[ begin ].mEnd - begin;
+		const uint32_t start	= focused != nullptr ? focused->mSlot - begin : ( forward ? count - 1 : 0 );
+		for ( uint32_t i = 1; i <= count; ++i ) {
+			UiTreeT<T, P, F>* node = registry.mSlots[ begin + ( start + ( forward ? i : count - i ) ) % count ].mNode;
+			bool enabled = node->isFocusable();
+			for ( UiTreeT<T, P, F>* iter = node; enabled && iter != nullptr; iter = iter->mParent ) {
+				enabled = iter->mState.mEnabled;
+			}
+			if ( enabled ) {
+				node->setFocused( true );
+				return true;
+			}
+		}
+		return false;
 	}
-	
-	template<typename V, typename Y>
-	inline UiTreeT<T>& connectTouchOverEventHandler( V eventHandler, Y* eventHandlerObject )
+
+	/*
+	 * Returns the first slot in [begin, end) whose own shape 
+	 * contains the world space point "v", or "end". Nodes are 
+	 * tested as "t", or as their own collision type when "t" 
+	 * is null. With SpatialIndex_Bvh, the caller validates the 
+	 * bounds of a node spanning the range.
+	 */
+	static inline uint32_t calcFirstHit( Registry& registry, uint32_t begin, uint32_t end, 
+		const ci::vec3& v, const CollisionType* t )
 	{
-		return connectTouchOverEventHandler( std::bind( eventHandler, eventHandlerObject, std::placeholders::_1, std::placeholders::_2 ) );
+		if ( registry.mSpatialIndex == SpatialIndex_Grid ) {
+			registry.validateGrid();
+
+			// The first hit in preorder is the candidate with the lowest slot.
+			uint32_t hit = end;
+			auto test = [ & ]( const std::vector<UiTreeT<T, P, F>*>& nodes )
+			{
+				for ( const UiTreeT<T, P, F>* node : nodes ) {
+					if ( node->mSlot >= begin && node->mSlot < hit && node->getSpatial()->mBounds.contains( ci::vec2( v ) ) ) {
+						if ( node->intersects( registry.mTransforms, Transform::transform( node->getInverseFrameMatrix( registry.mTransforms ), v ), 
+							t == nullptr ? node->mState.mCollisionType : *t ) ) {
+							hit = node->mSlot;
+						}
+					}
+				}
+			};
+			test( registry.mGrid.mLarge );
+			ci::ivec2 a;
+			ci::ivec2 b;
+			if ( registry.mGrid.getCells( ci::Rectf( ci::vec2( v ), ci::vec2( v ) ), a, b ) ) {
+				auto iter = registry.mGrid.mCells.find( Grid::key( a.x, a.y ) );
+				if ( iter != registry.mGrid.mCells.end() ) {
+					test( iter->second );
+				}
+			}
+			return hit;
+		}
+
+		const bool cull = registry.mSpatialIndex == SpatialIndex_Bvh;
+		for ( uint32_t i = begin; i < end; ++i ) {
+			const UiTreeT<T, P, F>& node = *registry.mSlots[ i ].mNode;
+			if ( cull && !node.getSpatial()->mSubtreeBounds.contains( ci::vec2( v ) ) ) {
+				i = registry.mSlots[ i ].mEnd - 1;
+				continue;
+			}
+			if ( node.intersects( registry.mTransforms, Transform::transform( node.getInverseFrameMatrix( registry.mTransforms ), v ), 
+				t == nullptr ? node.mState.mCollisionType : *t ) ) {
+				return i;
+			}
+		}
+		return end;
 	}
 
-	inline UiTreeT<T>& disconnectTouchOverEventHandler()
+	// Tests a point in this node's local frame, where the node's shape sits at the origin.
+	inline bool intersects( TransformStore& store, const ci::vec3& v, CollisionType t ) const
 	{
-		mEventHandlerTouchOver = nullptr;
-		return *this;
+		const ci::vec3 s = Transform::toVec3( store.mScale.mValue.get( getLane( store ) ) );
+		switch ( t ) {
+		case CollisionType_Circle:
+			return glm::length( ci::vec2( v ) ) < std::min( s.x, s.y );
+		case CollisionType_Cube:
+			return ci::AxisAlignedBox( s * -0.5f, s * 0.5f ).contains( v );
+		case CollisionType_Rect:
+			return ci::Rectf( ci::vec2( 0.0f ), ci::vec2( s ) ).contains( ci::vec2( v ) );
+		case CollisionType_Sphere:
+			return glm::length( v ) < std::min( s.x, std::min( s.y, s.z ) );
+		}
+		return false;
 	}
 
-	inline UiTreeT<T>& connectUpdateEventHandler( const std::function<void( UiTreeT<T>* )>& eventHandler )
+	inline void registerNodes( Registry& registry )
 	{
-		mEventHandlerUpdate = eventHandler;
-		return *this;
+		registry.insert( *this );
+		for ( auto& iter : mChildren ) {
+			iter.second.registerNodes( registry );
+		}
 	}
-	
-	template<typename V, typename Y>
-	inline UiTreeT<T>& connectUpdateEventHandler( V eventHandler, Y* eventHandlerObject )
+
+	// Removes the subtrees under this node that are not in "committed", the index from before a batch.
+	inline void removeBatchedNodes( Registry& registry, const std::unordered_map<uint64_t, UiTreeT<T, P, F>*>& committed )
 	{
-		return connectUpdateEventHandler( std::bind( eventHandler, eventHandlerObject, std::placeholders::_1 ) );
+		for ( auto iter = mChildren.begin(); iter != mChildren.end(); ) {
+			auto node = committed.find( iter->first );
+			if ( node == committed.end() || node->second != &iter->second ) {
+				iter->second.releaseHandles( registry );
+				iter = mChildren.erase( iter );
+			} else {
+				iter->second.removeBatchedNodes( registry, committed );
+				++iter;
+			}
+		}
 	}
 
-	inline UiTreeT<T>& disconnectUpdateEventHandler()
+	// Returns an ID above "baseId" and every ID in this subtree, which is not yet indexed.
+	inline uint64_t calcNextId( uint64_t baseId = 0 ) const
 	{
-		mEventHandlerUpdate = nullptr;
-		return *this;
+		uint64_t id = std::max<uint64_t>( baseId, mId ) + 1;
+		for ( const auto& iter : mChildren ) {
+			id = std::max<uint64_t>( id, iter.second.calcNextId( id ) );
+		}
+		return id;
 	}
 
-	inline void update()
+	// Registers nodes without replacing existing entries, collecting IDs already present.
+	inline void registerNodes( Registry& registry, std::vector<uint64_t>& duplicates )
 	{
+		if ( registry.mNodes.insert( std::make_pair( mId, this ) ).second ) {
+			registry.mNextId = std::max<uint64_t>( registry.mNextId, mId + 1 );
+			registry.acquireHandle( *this );
+			registry.wake( *this );
+			invalidateBounds();
+			propagateRoutes();
+			if ( registry.mSpatialIndex == SpatialIndex_Grid ) {
+				registry.mGrid.erase( *this );
+			}
+			Grid::reset( *this );
+			if ( registry.mSpatialIndex == SpatialIndex_Grid ) {
+				registry.mGrid.queue( *this );
+			}
+		} else {
+			duplicates.push_back( mId );
+		}
 		for ( auto& iter : mChildren ) {
-			iter.second.update();
+			iter.second.registerNodes( registry, duplicates );
 		}
+	}
 
-		static const float epsilon = 0.01f;
-
-		{
-			float l = (float)glm::length( mRegistrationVelocity );
-			if ( l < epsilon ) {
-				mRegistrationVelocityDecay = 0.0f;
-			}
-			if ( l > 0.0f ) {
-				mRegistrationTarget		+= mRegistrationVelocity;
-				mRegistrationVelocity	*= mRegistrationVelocityDecay;
-			}
+	/*
+	 * Refreshes the routes of this node and its ancestors after 
+	 * a handler is connected or disconnected, or a child is 
+	 * removed. Routes may over-report after a subtree is moved 
+	 * out or a batch fails, until the arena is next rebuilt.
+	 */
+	inline void invalidateRoutes()
+	{
+		Input* input = getInput();
+		if ( input == nullptr ) {
+			return;
 		}
-		{
-			float l = (float)glm::length( mRotationVelocity );
-			if ( l < epsilon ) {
-				mRotationVelocityDecay = 0.0f;
-			}
-			if ( l > 0.0f ) {
-				mRotationTarget		+= mRotationVelocity;
-				mRotationVelocity	*= mRotationVelocityDecay;
-			}
+		uint16_t routes = calcRoutes();
+		for ( const auto& iter : mChildren ) {
+			routes |= iter.second.getRoutes();
 		}
-		{
-			float l = (float)glm::length( mScaleVelocity );
-			if ( l < epsilon ) {
-				mScaleVelocityDecay = 0.0f;
-			}
-			if ( l > 0.0f ) {
-				mScaleTarget	+= mScaleVelocity;
-				mScaleVelocity	*= mScaleVelocityDecay;
-			}
+		if ( ( routes & input->mRoutes ) == input->mRoutes ) {
+			input->mRoutes = routes;
+			propagateRoutes();
+			return;
 		}
-		{
-			float l = (float)glm::length( mTranslateVelocity );
-			if ( l < epsilon ) {
-				mTranslateVelocityDecay = 0.0f;
+		input->mRoutes = routes;
+		for ( UiTreeT<T, P, F>* node = mParent; node != nullptr; node = node->mParent ) {
+			routes = node->calcRoutes();
+			for ( const auto& iter : node->mChildren ) {
+				routes |= iter.second.getRoutes();
 			}
-			if ( l > 0.0f ) {
-				mTranslateTarget	+= mTranslateVelocity;
-				mTranslateVelocity	*= mTranslateVelocityDecay;
+			if ( routes == node->getRoutes() ) {
+				break;
 			}
+			node->getInput()->mRoutes = routes;
 		}
+	}
 
-		mRegistration	= ci::lerp( mRegistration, mRegistrationTarget, mRegistrationSpeed );
-		mRotation		= glm::slerp( mRotation, mRotationTarget, mRotationSpeed );
-		mScale			= ci::lerp( mScale, mScaleTarget, mScaleSpeed );
-		mTranslate		= ci::lerp( mTranslate, mTranslateTarget, mTranslateSpeed );
-
-		if ( mEventHandlerUpdate != nullptr ) {
-			mEventHandlerUpdate( this );
+	// Adds this node's routes to each of its ancestors.
+	inline void propagateRoutes()
+	{
+		const Input* input = getInput();
+		if ( input == nullptr ) {
+			return;
+		}
+		for ( UiTreeT<T, P, F>* node = mParent; node != nullptr && ( node->getRoutes() | input->mRoutes ) != node->getRoutes(); node = node->mParent ) {
+			node->getInput()->mRoutes |= input->mRoutes;
 		}
 	}
-protected:
-	inline void keyDown( ci::app::KeyEvent& event )
+
+	// Marks this node and its descendants for recalculation. A dirty node's descendants are always dirty.
+	inline void invalidateWorldMatrix()
 	{
-		if ( mEnabled ) {
-			for ( auto& iter : mChildren ) {
-				iter.second.keyDown( event );
-				if ( event.isHandled() ) {
-					return;
-				}
-			}
-			if ( mEventHandlerKeyDown != nullptr ) {
-				mEventHandlerKeyDown( this, event );
-			}
-		}
+		UiTreeT<T, P, F>& root = getRoot();
+		invalidateWorldMatrix( root.mRegistry != nullptr && root.mRegistry->mSpatialIndex == SpatialIndex_Grid ? 
+			&root.mRegistry->mGrid : nullptr );
 	}
 
-	inline void keyUp( ci::app::KeyEvent& event )
+	// Queues each invalidated node with "grid", if one is in use.
+	inline void invalidateWorldMatrix( Grid* grid )
 	{
-		if ( mEnabled ) {
-			for ( auto& iter : mChildren ) {
-				iter.second.keyUp( event );
-				if ( event.isHandled() ) {
-					return;
-				}
+		if ( !mWorldDirty ) {
+			mWorldDirty = true;
+			invalidateBounds();
+			if ( grid != nullptr ) {
+				grid->queue( *this );
 			}
-			if ( mEventHandlerKeyUp != nullptr ) {
-				mEventHandlerKeyUp( this, event );
+			for ( auto& iter : mChildren ) {
+				iter.second.invalidateWorldMatrix( grid );
 			}
 		}
 	}
 
-	inline void mouseDown( ci::app::MouseEvent& event )
+	// Marks this node's bounds for refitting, along with its ancestors' subtree bounds.
+	inline void invalidateBounds()
 	{
-		if ( mEnabled ) {
-			bool handled = false;
-			for ( auto& iter : mChildren ) {
-				iter.second.mouseDown( event );
-				if ( event.isHandled() ) {
-					handled = true;
-					return;
-				}
-			}
-			mouseOver( event );
-			if ( !handled && mEventHandlerMouseDown != nullptr ) {
-				mEventHandlerMouseDown( this, event );
-			}
+		if ( getSpatial() == nullptr ) {
+			return;
+		}
+		getSpatial()->mBoundsDirty = true;
+		for ( UiTreeT<T, P, F>* node = mParent; node != nullptr && !node->getSpatial()->mBoundsDirty; node = node->mParent ) {
+			node->getSpatial()->mBoundsDirty = true;
 		}
 	}
 
-	inline void mouseDrag( ci::app::MouseEvent& event )
+	// Refits stale bounds bottom-up, visiting only dirty subtrees.
+	inline void validateBounds() const
 	{
-		if ( mEnabled ) {
-			bool handled = false;
-			for ( auto& iter : mChildren ) {
-				iter.second.mouseDrag( event );
-				if ( event.isHandled() ) {
-					handled = true;
-					return;
-				}
-			}
-			mouseOver( event );
-			if ( !handled && mEventHandlerMouseDrag != nullptr ) {
-				mEventHandlerMouseDrag( this, event );
-			}
+		const Spatial* spatial = getSpatial();
+		if ( spatial != nullptr && spatial->mBoundsDirty ) {
+			validateBounds( getTransforms() );
 		}
 	}
 
-	inline void mouseMove( ci::app::MouseEvent& event )
+	inline void validateBounds( TransformStore& store ) const
 	{
-		if ( mEnabled ) {
-			bool handled = false;
-			for ( auto& iter : mChildren ) {
-				iter.second.mouseMove( event );
-				if ( event.isHandled() ) {
-					handled = true;
-					break;
-				}
-			}
-			mouseOver( event );
-			if ( !handled && mEventHandlerMouseMove != nullptr ) {
-				mEventHandlerMouseMove( this, event );
+		Spatial* spatial = getSpatial();
+		if ( spatial == nullptr || !spatial->mBoundsDirty ) {
+			return;
+		}
+		validateWorldMatrix( store );
+		const float inf = std::numeric_limits<float>::max();
+		if ( !Transform::isFlat( mFrameMatrix ) ) {
+			spatial->mBounds = ci::Rectf( -inf, -inf, inf, inf );
+		} else {
+			// A local box enclosing the shape of every collision type.
+			const ci::vec2 s( store.mScale.mValue.get( getLane( store ) ) );
+			const float r		= std::abs( std::min( s.x, s.y ) );
+			const ci::vec2 e	= glm::max( glm::abs( s ) * 0.5f, ci::vec2( r ) );
+			const ci::vec2 a	= glm::min( glm::min( s, ci::vec2( 0.0f ) ), -e );
+			const ci::vec2 b	= glm::max( glm::max( s, ci::vec2( 0.0f ) ), e );
+			const ci::vec2 corners[ 4 ] = { a, ci::vec2( b.x, a.y ), b, ci::vec2( a.x, b.y ) };
+			ci::vec2 lo( inf );
+			ci::vec2 hi( -inf );
+			for ( const ci::vec2& c : corners ) {
+				const ci::vec2 w( Transform::transform( mFrameMatrix, ci::vec3( c, 0.0f ) ) );
+				lo = glm::min( lo, w );
+				hi = glm::max( hi, w );
 			}
+
+			// Pad for rounding so points on an edge still reach the exact test.
+			const ci::vec2 m	= glm::max( glm::abs( lo ), glm::abs( hi ) );
+			const ci::vec2 pad( ( 1.0f + std::max( m.x, m.y ) ) * 1e-5f );
+			spatial->mBounds = ci::Rectf( lo - pad, hi + pad );
+		}
+		spatial->mSubtreeBounds = spatial->mBounds;
+		for ( const auto& iter : mChildren ) {
+			iter.second.validateBounds( store );
+			spatial->mSubtreeBounds.include( iter.second.getSpatial()->mSubtreeBounds );
 		}
+		spatial->mBoundsDirty = false;
 	}
 
-	inline void mouseOver( ci::app::MouseEvent& event )
+	inline void validateWorldMatrix() const
 	{
-		bool mouseOver	= mMouseOver;
-		mMouseOver		= contains( ci::vec2( event.getPos() ), mCollisionType );
-		if ( mouseOver != mMouseOver ) {
-			if ( mMouseOver && mEventHandlerMouseOver != nullptr ) {
-				mEventHandlerMouseOver( this );
-			} else if ( !mMouseOver && mEventHandlerMouseOut != nullptr ) {
-				mEventHandlerMouseOut( this );
-			}
+		if ( mWorldDirty ) {
+			validateWorldMatrix( getTransforms() );
 		}
 	}
 
-	inline void mouseUp( ci::app::MouseEvent& event )
+	// Takes the root's store so a pass over many nodes looks it up once.
+	inline void validateWorldMatrix( TransformStore& store ) const
 	{
-		if ( mEnabled ) {
-			bool handled = false;
-			for ( auto& iter : mChildren ) {
-				iter.second.mouseUp( event );
-				if ( event.isHandled() ) {
-					handled = true;
-					break;
-				}
+		if ( mWorldDirty ) {
+			if ( mParent != nullptr ) {
+				mParent->validateWorldMatrix( store );
 			}
-			mouseOver( event );
-			if ( !handled && mEventHandlerMouseUp != nullptr ) {
-				mEventHandlerMouseUp( this, event );
+			const uint32_t lane	= getLane( store );
+			mFrameMatrix	= Transform::calcFrame( mParent != nullptr ? mParent->mFrameMatrix : MatrixType( 1.0f ), 
+				store.mTranslate.mValue.get( lane ) - store.mRegistration.mValue.get( lane ), store.mRotation.mValue.get( lane ), 
+				store.mGroupScale.mValue.get( lane ) );
+			mWorldMatrix	= Transform::calcScaled( mFrameMatrix, store.mScale.mValue.get( lane ) );
+			mWorldDirty		= false;
+			Spatial* spatial = getSpatial();
+			if ( spatial != nullptr ) {
+				spatial->mInverseDirty = true;
 			}
 		}
 	}
 
-	inline void mouseWheel( ci::app::MouseEvent& event )
+	/*
+	 * Inverts the frame rather than the world matrix, which is 
+	 * singular for 2D nodes. The inverse is cached with the 
+	 * spatial index compiled in, and recomputed otherwise.
+	 */
+	inline MatrixType getInverseFrameMatrix( TransformStore& store ) const
 	{
-		if ( mEnabled ) {
-			for ( auto& iter : mChildren ) {
-				iter.second.mouseWheel( event );
-				if ( event.isHandled() ) {
-					return;
-				}
-			}
-			if ( mEventHandlerMouseWheel != nullptr ) {
-				mEventHandlerMouseWheel( this, event );
-			}
+		validateWorldMatrix( store );
+		Spatial* spatial = getSpatial();
+		if ( spatial == nullptr ) {
+			return Transform::calcInverse( mFrameMatrix );
 		}
+		if ( spatial->mInverseDirty ) {
+			spatial->mInverseFrameMatrix	= Transform::calcInverse( mFrameMatrix );
+			spatial->mInverseDirty			= false;
+		}
+		return spatial->mInverseFrameMatrix;
 	}
-	
-	inline void resize()
+
+	inline void releaseHandles( Registry& registry )
 	{
-		if ( mEnabled ) {
-			for ( auto& iter : mChildren ) {
-				iter.second.resize();
-			}
-			if ( mEventHandlerResize != nullptr ) {
-				mEventHandlerResize( this );
-			}
+		registry.releaseHandle( *this );
+		for ( auto& iter : mChildren ) {
+			iter.second.releaseHandles( registry );
 		}
 	}
-	
-	inline void touchesBegan( ci::app::TouchEvent& event )
+
+	inline void unregisterNodes( Registry& registry )
 	{
-		if ( mEnabled ) {
-			bool handled = false;
-			for ( auto& iter : mChildren ) {
-				iter.second.touchesBegan( event );
-				if ( event.isHandled() ) {
-					handled = true;
-					break;
-				}
-			}
-			touchOver( event.getTouches() );
-			if ( !handled && mEventHandlerTouchesBegan != nullptr ) {
-				mEventHandlerTouchesBegan( this, event );
-			}
+		registry.erase( *this );
+		for ( auto& iter : mChildren ) {
+			iter.second.unregisterNodes( registry );
 		}
 	}
 
-	inline void touchesEnded( ci::app::TouchEvent& event )
+	/*
+	 * Adds this node to its tree's active set so the next update() 
+	 * integrates it. Nodes outside a tree, or added during a 
+	 * batch, are woken when they are registered.
+	 */
+	inline void wake()
 	{
-		if ( mEnabled ) {
-			bool handled = false;
-			for ( auto& iter : mChildren ) {
-				iter.second.touchesEnded( event );
-				if ( event.isHandled() ) {
-					handled = true;
-					break;
-				}
-			}
-			auto removeTouch = [ & ]( uint32_t id ) -> bool
-			{
-				for ( std::vector<ci::app::TouchEvent::Touch>::iterator iter = mTouches.begin(); iter != mTouches.end(); ) {
-					if ( iter->getId() == id ) {
-						mTouches.erase( iter );
-						return true;
-					} else {
-						++iter;
-					}
-				}
-				return false;
-			};
-			for ( const ci::app::TouchEvent::Touch& iter : event.getTouches() ) {
-				uint32_t id = iter.getId();
-				if ( removeTouch( id ) && mEventHandlerTouchOut != nullptr  ) {
-					mEventHandlerTouchOut( this, id );
-				}
-			}
-			if ( !handled && mEventHandlerTouchesEnded != nullptr ) {
-				mEventHandlerTouchesEnded( this, event );
+		UiTreeT<T, P, F>& root = getRoot();
+		if ( root.mRegistry != nullptr && root.mRegistry->mBatchDepth == 0 ) {
+			auto iter = root.mRegistry->mNodes.find( mId );
+			if ( iter != root.mRegistry->mNodes.end() && iter->second == this ) {
+				root.mRegistry->wake( *this );
 			}
 		}
 	}
 
-	inline void touchesMoved( ci::app::TouchEvent& event )
+	/*
+	 * Throws if this node, or any of its children, collides with
+	 * an ID in the registry or with the ID reserved for the
+	 * subtree's new root. When moving nodes within the same tree,
+	 * pass "moving" to ignore the entries of the nodes themselves.
+	 */
+	inline void validateIds( const Registry& registry, uint64_t id, bool moving = false ) const
 	{
-		if ( mEnabled ) {
-			bool handled = false;
-			for ( auto& iter : mChildren ) {
-				iter.second.touchesMoved( event );
-				if ( event.isHandled() ) {
-					handled = true;
-					break;
-				}
+		if ( mId == id ) {
+			throw ExcDuplicateId( mId );
+		}
+		auto iter = registry.mNodes.find( mId );
+		if ( iter != registry.mNodes.end() && !( moving && iter->second == this ) ) {
+			throw ExcDuplicateId( mId );
+		}
+		for ( const auto& child : mChildren ) {
+			child.second.validateIds( registry, id, moving );
+		}
+	}
+
+	/*
+	 * Throws ExcDuplicateId if a descendant of rhs has this 
+	 * node's ID, or an ID indexed outside this node's subtree. 
+	 * The subtree is about to be replaced by rhs's, so its own 
+	 * IDs are free. When "moving", a node indexed under its own 
+	 * ID keeps it.
+	 */
+	inline void validateReplacementIds( const Registry& registry, const UiTreeT<T, P, F>& rhs, bool moving ) const
+	{
+		for ( const auto& iter : rhs.mChildren ) {
+			const UiTreeT<T, P, F>& node = iter.second;
+			if ( node.mId == mId ) {
+				throw ExcDuplicateId( node.mId );
 			}
-			if ( !handled && mEventHandlerTouchesMoved != nullptr ) {
-				mEventHandlerTouchesMoved( this, event );
+			auto found = registry.mNodes.find( node.mId );
+			if ( found != registry.mNodes.end() && !( moving && found->second == &node ) && lookup( node.mId ) == nullptr ) {
+				throw ExcDuplicateId( node.mId );
 			}
-			touchOver( event.getTouches() );
+			validateReplacementIds( registry, node, moving );
 		}
 	}
 
-	inline void touchOver( const std::vector<ci::app::TouchEvent::Touch>& touches )
+	// Returns the node with this ID if it is this node or one of its descendants.
+	inline const UiTreeT<T, P, F>* lookup( uint64_t id ) const
 	{
-		std::vector<ci::app::TouchEvent::Touch> t;
-		for ( const ci::app::TouchEvent::Touch& touch : touches ) {
-			const uint32_t id	= touch.getId();
-			const bool over		= contains( touch.getPos(), mCollisionType );
-			const bool prev		= contains( touch.getPrevPos(), mCollisionType );
-			if ( mEventHandlerTouchOver != nullptr && over && !prev ) {
-				mEventHandlerTouchOver( this, id );
-			} else if ( mEventHandlerTouchOut != nullptr && !over && prev ) {
-				mEventHandlerTouchOut( this, id );
-			}
-			if ( over ) {
-				t.push_back( touch );
-			}
-		}
-		for ( const ci::app::TouchEvent::Touch& a : t ) {
-			bool found	= false;
-			uint32_t id = a.getId();
-			for ( const ci::app::TouchEvent::Touch& b : mTouches ) {
-				if ( id == b.getId() ) {
-					found = true;
-					break;
+		if ( mId == id ) {
+			return this;
+		}
+		const Registry& registry = const_cast<UiTreeT<T, P, F>*>( this )->getRegistry();
+		auto iter = registry.mNodes.find( id );
+		if ( iter == registry.mNodes.end() ) {
+			return nullptr;
+		}
+		if ( mParent != nullptr ) {
+			for ( const UiTreeT<T, P, F>* node = iter->second->mParent; node != this; node = node->mParent ) {
+				if ( node == nullptr ) {
+					return nullptr;
 				}
 			}
-			if ( !found ) {
-				mTouches.push_back( a );
-				if ( mEventHandlerTouchOver != nullptr ) {
-					mEventHandlerTouchOver( this, id );
-				}
+		}
+		return iter->second;
+	}
+
+	/*
+	 * Links each node outside "removed" whose parent lies inside 
+	 * it back to the node holding it. Nodes only point into 
+	 * another subtree after setParent(). The arena must be valid.
+	 */
+	static inline void relinkParents( Registry& registry, const UiTreeT<T, P, F>& removed )
+	{
+		const uint32_t begin	= removed.mSlot;
+		const uint32_t end		= registry.mSlots[ begin ].mEnd;
+		for ( uint32_t i = 0; i < (uint32_t)registry.mSlots.size(); ++i ) {
+			if ( i == begin ) {
+				i = end - 1;
+				continue;
+			}
+			UiTreeT<T, P, F>* node = registry.mSlots[ i ].mNode;
+			if ( node->mParent != nullptr && node->mParent->mSlot >= begin && node->mParent->mSlot < end ) {
+				node->mParent = registry.mSlots[ registry.mSlots[ i ].mParent ].mNode;
+				node->invalidateWorldMatrix();
 			}
 		}
 	}
 
-	inline size_t calcNumNodes( size_t count ) const
+	// Returns the node whose child map physically holds this ID.
+	inline UiTreeT<T, P, F>* findOwner( uint64_t id )
 	{
+		if ( mChildren.find( id ) != mChildren.end() ) {
+			return this;
+		}
 		for ( auto& iter : mChildren ) {
-			count = iter.second.calcNumNodes( count );
+			UiTreeT<T, P, F>* owner = iter.second.findOwner( id );
+			if ( owner != nullptr ) {
+				return owner;
+			}
 		}
-		return count + 1;
+		return nullptr;
 	}
 
-	std::map<uint64_t, UiTreeT<T>>								mChildren;
-	T															mData;
+	std::map<uint64_t, UiTreeT<T, P, F>>						mChildren;
+	mutable uint32_t											mLane;			// This node's lane in the root's transform store
+	std::unique_ptr<TransformStore>								mTransforms;	// Outlives mRegistry, which refers to it
+	std::unique_ptr<Registry>									mRegistry;
+	Handle														mHandle;		// Entry in the root's handle table
+	uint32_t													mSlot;			// Position in the root's node arena
 	uint64_t													mId;
-	UiTreeT<T>*													mParent;
-
-	CollisionType												mCollisionType;
-	bool														mEnabled;
-	bool														mMouseOver;
-	std::vector<ci::app::TouchEvent::Touch>						mTouches;
-	bool														mVisible;
-
-	ci::vec3													mRegistration;
-	float														mRegistrationSpeed;
-	ci::vec3													mRegistrationTarget;
-	ci::vec3													mRegistrationVelocity;
-	float 														mRegistrationVelocityDecay;
-
-	ci::quat													mRotation;
-	float														mRotationSpeed;
-	ci::quat													mRotationTarget;
-	ci::quat													mRotationVelocity;
-	float														mRotationVelocityDecay;
-
-	ci::vec3													mScale;
-	float														mScaleSpeed;
-	ci::vec3													mScaleTarget;
-	ci::vec3													mScaleVelocity;
-	float														mScaleVelocityDecay;
-
-	ci::vec3													mTranslate;
-	float														mTranslateSpeed;
-	ci::vec3													mTranslateTarget;
-	ci::vec3													mTranslateVelocity;
-	float														mTranslateVelocityDecay;
-
-	ci::signals::Connection										mConnectionKeyDown;
-	ci::signals::Connection										mConnectionKeyUp;
-	ci::signals::Connection										mConnectionMouseDown;
-	ci::signals::Connection										mConnectionMouseDrag;
-	ci::signals::Connection										mConnectionMouseMove;
-	ci::signals::Connection										mConnectionMouseUp;
-	ci::signals::Connection										mConnectionMouseWheel;
-	ci::signals::Connection										mConnectionResize;
-	ci::signals::Connection										mConnectionTouchesBegan;
-	ci::signals::Connection										mConnectionTouchesEnded;
-	ci::signals::Connection										mConnectionTouchesMoved;
-
-	std::function<void( UiTreeT<T>* )>							mEventHandlerDisable;
-	std::function<void( UiTreeT<T>* )>							mEventHandlerEnable;
-	std::function<void( UiTreeT<T>* )>							mEventHandlerHide;
-	std::function<void( UiTreeT<T>*, ci::app::KeyEvent& )>		mEventHandlerKeyDown;
-	std::function<void( UiTreeT<T>*, ci::app::KeyEvent& )>		mEventHandlerKeyUp;
-	std::function<void( UiTreeT<T>*, ci::app::MouseEvent& )>	mEventHandlerMouseDown;
-	std::function<void( UiTreeT<T>*, ci::app::MouseEvent& )>	mEventHandlerMouseDrag;
-	std::function<void( UiTreeT<T>*, ci::app::MouseEvent& )>	mEventHandlerMouseMove;
-	std::function<void( UiTreeT<T>* )>							mEventHandlerMouseOut;
-	std::function<void( UiTreeT<T>* )>							mEventHandlerMouseOver;
-	std::function<void( UiTreeT<T>*, ci::app::MouseEvent& )>	mEventHandlerMouseUp;
-	std::function<void( UiTreeT<T>*, ci::app::MouseEvent& )>	mEventHandlerMouseWheel;
-	std::function<void( UiTreeT<T>* )>							mEventHandlerResize;
-	std::function<void( UiTreeT<T>* )>							mEventHandlerShow;
-	std::function<void( UiTreeT<T>*, ci::app::TouchEvent& )>	mEventHandlerTouchesBegan;
-	std::function<void( UiTreeT<T>*, ci::app::TouchEvent& )>	mEventHandlerTouchesEnded;
-	std::function<void( UiTreeT<T>*, ci::app::TouchEvent& )>	mEventHandlerTouchesMoved;
-	std::function<void( UiTreeT<T>*, uint32_t )>				mEventHandlerTouchOut;
-	std::function<void( UiTreeT<T>*, uint32_t )>				mEventHandlerTouchOver;
-	std::function<void( UiTreeT<T>* )>							mEventHandlerUpdate;
+	UiTreeT<T, P, F>*											mParent;
+
+	State														mState;
+
+	mutable MatrixType											mFrameMatrix;	// World transform inherited by children
+	mutable SpatialType											mSpatial;
+	mutable bool												mWorldDirty;
+	mutable MatrixType											mWorldMatrix;
+
+	std::unique_ptr<EventHandlers>								mEventHandlers;
 
 	/////////////////////////////////////////////////////////////////////////////////
 
@@ -1700,5 +6452,23 @@ public:
 			std::sprintf( this->mMessage, "ID '%lu' already exists in tree.", (unsigned long)id );
 		}
 	};
+
+	class ExcInvalidParent : public Exception 
+	{
+	public:
+		ExcInvalidParent( uint64_t id ) throw()
+		{
+			std::sprintf( this->mMessage, "Node '%lu' cannot be linked to a parent in another tree. Use addChild() to move it.", (unsigned long)id );
+		}
+	};
+
+	class ExcInvalidHandle : public Exception 
+	{
+	public:
+		ExcInvalidHandle( Handle handle ) throw()
+		{
+			std::sprintf( this->mMessage, "Handle '%llu' does not refer to a node in this tree. Its node may have been removed.", (unsigned long long)handle );
+		}
+	};
 };
  
\ No newline at end of file
@@ -0,0 +1,169 @@
+/*
+ * UITREE TEST
+ *
+ * Regression checks for tree modification and event wiring.
+ * Each check logs its result; the application quits with a
+ * non-zero exit code if any of them fail.
+ */
+
+#include "cinder/app/App.h"
+#include "UiTree.h"
+
+typedef UiTreeT<ci::Colorf> UiTree;
+
+class UiTreeTestApp : public ci::app::App
+{
+public:
+	void		setup() override;
+private:
+	void		check( bool pass, const std::string& name );
+	void		testCrossRootParent();
+	void		testRemoveLinkedParent();
+	void		testMoveEnabledRoot();
+
+	size_t		mFailures;
+};
+
+#include "cinder/app/RendererGl.h"
+#include "cinder/Log.h"
+#include "cinder/Rand.h"
+
+using namespace ci;
+using namespace ci::app;
+using namespace std;
+
+void UiTreeTestApp::setup()
+{
+	mFailures = 0;
+
+	testCrossRootParent();
+	testRemoveLinkedParent();
+	testMoveEnabledRoot();
+
+	CI_LOG_I( mFailures << " failure(s)" );
+	if ( mFailures > 0 ) {
+		exit( 1 );
+	}
+	quit();
+}
+
+void UiTreeTestApp::check( bool pass, const string& name )
+{
+	if ( pass ) {
+		CI_LOG_I( "PASS " << name );
+	} else {
+		CI_LOG_E( "FAIL " << name );
+		++mFailures;
+	}
+}
+
+void UiTreeTestApp::testCrossRootParent()
+{
+	UiTree a;
+	UiTree b;
+	UiTree& node = a.createAndReturnChild( 1 );
+	node.createChild( 2 );
+
+	bool threw = false;
+	try {
+		node.setParent( &b );
+	} catch ( const UiTree::ExcInvalidParent& ) {
+		threw = true;
+	}
+	check( threw, "setParent() rejects a parent in another tree" );
+	check( node.getParent() == &a && a.exists( 2 ) && !b.exists( 1 ), "rejected setParent() leaves the node in place" );
+
+	threw = false;
+	try {
+		node.setParent( nullptr );
+	} catch ( const UiTree::ExcInvalidParent& ) {
+		threw = true;
+	}
+	check( threw, "setParent() rejects detaching a child" );
+
+	a.update();
+	b.update();
+	check( a.exists( 2 ), "both roots update after a rejected setParent()" );
+}
+
+void UiTreeTestApp::testRemoveLinkedParent()
+{
+	// Mirrors Tutorial 10: a flat tree whose nodes link to
+	// each other, with linked parents removed while in use.
+	UiTree root;
+	uint64_t id = 1;
+	for ( size_t i = 0; i < 40; ++i ) {
+		root.createAndReturnChild( id++ ).scale( vec2( randFloat( 1.0f, 50.0f ) ) );
+	}
+
+	bool linked = true;
+	for ( size_t frame = 0; frame < 200; ++frame ) {
+		if ( frame % 3 == 0 ) {
+			list<UiTree*> nodes = root.query( []( const UiTree& node )
+			{
+				return node.getParent() != nullptr && node.getParent()->getParent() != nullptr;
+			} );
+			if ( !nodes.empty() ) {
+				root.removeChild( nodes.front()->getParent()->getId() );
+			}
+			root.createAndReturnChild( id++ ).scale( vec2( randFloat( 1.0f, 50.0f ) ) );
+		}
+
+		list<UiTree*> nodes = root.query( []( const UiTree& node )
+		{
+			return true;
+		} );
+		for ( UiTree* a : nodes ) {
+			if ( a->getParent() == nullptr ) {
+				continue;
+			}
+			if ( !root.exists( a->getParent()->getId() ) ) {
+				linked = false;
+			}
+			a->setTranslate( vec2( randFloat( -100.0f, 100.0f ), randFloat( -100.0f, 100.0f ) ) );
+
+			float d0 = numeric_limits<float>::max();
+			for ( UiTree* b : nodes ) {
+				if ( a != b && b->getScale().x > a->getScale().x ) {
+					const float d1 = glm::distance( a->getTranslate(), b->getTranslate() );
+					if ( d1 < d0 ) {
+						d0 = d1;
+						a->setParent( b );
+					}
+				}
+			}
+		}
+		root.update();
+		root.calcWorldMatrices();
+	}
+	check( linked, "removeChild() relinks nodes linked to the removed subtree" );
+}
+
+void UiTreeTestApp::testMoveEnabledRoot()
+{
+	size_t calls = 0;
+	unique_ptr<UiTree> source( new UiTree() );
+	source->enable().scale( vec2( getWindowSize() ) );
+	source->connectMouseDownEventHandler( [ &calls ]( UiTree* node, MouseEvent& event )
+	{
+		++calls;
+	} );
+
+	MouseEvent event( getWindow(), MouseEvent::LEFT_DOWN, 1, 1, MouseEvent::LEFT_DOWN, 0.0f, 0 );
+	getWindow()->emitMouseDown( &event );
+	check( calls == 1, "an enabled root receives window events" );
+
+	// The source is destroyed before the next event, so any 
+	// connection left capturing it would read freed memory.
+	UiTree root;
+	root = move( *source );
+	source.reset();
+	getWindow()->emitMouseDown( &event );
+	check( calls == 2, "a moved root receives each window event once" );
+
+	UiTree copy( move( root ) );
+	getWindow()->emitMouseDown( &event );
+	check( calls == 3, "a move-constructed root receives each window event once" );
+}
+
+CINDER_APP( UiTreeTestApp, RendererGl )
@@ -27,8 +27,13 @@
 // typedef a map to hold the node ID and a batch.
 typedef std::map<uint64_t, ci::gl::BatchRef>	IdBatchMap;
 
-// Node's will keep track of their color.
-typedef UiTreeT<ci::Colorf>						UiTree;
+/*
+ * Node's will keep track of their color. This tree is only 
+ * laid out and drawn, so we leave out animation and input 
+ * to keep each node small. It is also flat, so nodes store 
+ * 2D transforms.
+ */
+typedef UiTreeT<ci::Colorf, void, UiTreeFeature_Transform2D>	UiTree;
 
 class TutorialApp : public ci::app::App
 {